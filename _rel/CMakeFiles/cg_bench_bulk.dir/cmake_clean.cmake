@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/cg_bench_bulk.dir/bench/bench_bulk.cpp.o"
+  "CMakeFiles/cg_bench_bulk.dir/bench/bench_bulk.cpp.o.d"
+  "cg_bench_bulk"
+  "cg_bench_bulk.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/cg_bench_bulk.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
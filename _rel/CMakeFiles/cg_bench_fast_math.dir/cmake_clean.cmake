@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/cg_bench_fast_math.dir/bench/bench_fast_math.cpp.o"
+  "CMakeFiles/cg_bench_fast_math.dir/bench/bench_fast_math.cpp.o.d"
+  "cg_bench_fast_math"
+  "cg_bench_fast_math.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/cg_bench_fast_math.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
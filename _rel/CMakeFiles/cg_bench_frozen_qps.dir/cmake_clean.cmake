@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/cg_bench_frozen_qps.dir/bench/bench_frozen_qps.cpp.o"
+  "CMakeFiles/cg_bench_frozen_qps.dir/bench/bench_frozen_qps.cpp.o.d"
+  "cg_bench_frozen_qps"
+  "cg_bench_frozen_qps.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/cg_bench_frozen_qps.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
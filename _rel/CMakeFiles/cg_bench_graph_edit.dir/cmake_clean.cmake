@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/cg_bench_graph_edit.dir/bench/bench_graph_edit.cpp.o"
+  "CMakeFiles/cg_bench_graph_edit.dir/bench/bench_graph_edit.cpp.o.d"
+  "cg_bench_graph_edit"
+  "cg_bench_graph_edit.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/cg_bench_graph_edit.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/cg_bench_hvp.dir/bench/bench_hvp.cpp.o"
+  "CMakeFiles/cg_bench_hvp.dir/bench/bench_hvp.cpp.o.d"
+  "cg_bench_hvp"
+  "cg_bench_hvp.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/cg_bench_hvp.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
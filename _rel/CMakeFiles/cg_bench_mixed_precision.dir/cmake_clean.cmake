@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/cg_bench_mixed_precision.dir/bench/bench_mixed_precision.cpp.o"
+  "CMakeFiles/cg_bench_mixed_precision.dir/bench/bench_mixed_precision.cpp.o.d"
+  "cg_bench_mixed_precision"
+  "cg_bench_mixed_precision.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/cg_bench_mixed_precision.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
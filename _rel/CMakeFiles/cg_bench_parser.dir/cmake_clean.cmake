@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/cg_bench_parser.dir/bench/bench_parser.cpp.o"
+  "CMakeFiles/cg_bench_parser.dir/bench/bench_parser.cpp.o.d"
+  "cg_bench_parser"
+  "cg_bench_parser.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/cg_bench_parser.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/cg_bench_service.dir/bench/bench_service.cpp.o"
+  "CMakeFiles/cg_bench_service.dir/bench/bench_service.cpp.o.d"
+  "cg_bench_service"
+  "cg_bench_service.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/cg_bench_service.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
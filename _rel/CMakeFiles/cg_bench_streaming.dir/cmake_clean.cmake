@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/cg_bench_streaming.dir/bench/bench_streaming.cpp.o"
+  "CMakeFiles/cg_bench_streaming.dir/bench/bench_streaming.cpp.o.d"
+  "cg_bench_streaming"
+  "cg_bench_streaming.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/cg_bench_streaming.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
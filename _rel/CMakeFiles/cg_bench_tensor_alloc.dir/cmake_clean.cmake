@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/cg_bench_tensor_alloc.dir/bench/bench_tensor_alloc.cpp.o"
+  "CMakeFiles/cg_bench_tensor_alloc.dir/bench/bench_tensor_alloc.cpp.o.d"
+  "cg_bench_tensor_alloc"
+  "cg_bench_tensor_alloc.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/cg_bench_tensor_alloc.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
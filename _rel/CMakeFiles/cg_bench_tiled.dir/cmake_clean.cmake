@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/cg_bench_tiled.dir/bench/bench_tiled.cpp.o"
+  "CMakeFiles/cg_bench_tiled.dir/bench/bench_tiled.cpp.o.d"
+  "cg_bench_tiled"
+  "cg_bench_tiled.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/cg_bench_tiled.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
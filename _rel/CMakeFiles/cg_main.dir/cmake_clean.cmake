@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/cg_main.dir/src/main.cpp.o"
+  "CMakeFiles/cg_main.dir/src/main.cpp.o.d"
+  "cg_main"
+  "cg_main.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/cg_main.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/cg_tests.dir/tests/test_basic.cpp.o"
+  "CMakeFiles/cg_tests.dir/tests/test_basic.cpp.o.d"
+  "cg_tests"
+  "cg_tests.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/cg_tests.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,8 @@
+# CMake generated Testfile for 
+# Source directory: /root/repo
+# Build directory: /root/repo/_rel
+# 
+# This file includes the relevant testing commands required for 
+# testing this directory and lists subdirectories to be tested as well.
+add_test([=[basic_graph_test]=] "/root/repo/_rel/cg_tests")
+set_tests_properties([=[basic_graph_test]=] PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;22;add_test;/root/repo/CMakeLists.txt;0;")
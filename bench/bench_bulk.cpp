@@ -0,0 +1,61 @@
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+#include "cg/expression.hpp"
+#include "cg/frozen_graph.hpp"
+#include "cg/eval/bulk.hpp"
+
+// rows per second of bulk scoring at increasing thread counts, row-major and columnar input
+
+using T = double;
+using Clock = std::chrono::steady_clock;
+
+int main() {
+    constexpr std::size_t rows = 1 << 20;
+
+    cg::Graph<T> G;
+    auto x = cg::input(G, "x");
+    auto y = cg::input(G, "y");
+    auto z = cg::input(G, "z");
+    auto expr = cg::exp(-(x * x + y * y) / 2.0) * cg::cos(z) + cg::sqrt(x * x + 1.0) * y - z / (y * y + 1.0);
+    auto root = expr.root();
+    auto frozen = cg::freeze(std::move(G));
+
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<T> dist(-2.0, 2.0);
+    const std::size_t cols = frozen->inputs().size();
+    std::vector<T> row_major(rows * cols);
+    for (auto& v : row_major) v = dist(rng);
+
+    std::vector<std::vector<T>> storage(cols, std::vector<T>(rows));
+    cg::eval::Columnar<T> columnar;
+    for (std::size_t c = 0; c < cols; ++c) {
+        for (std::size_t r = 0; r < rows; ++r) storage[c][r] = row_major[r * cols + c];
+        columnar.columns.emplace_back(storage[c]);
+    }
+
+    std::vector<T> out(rows);
+    cg::eval::RowMajor<T> table{row_major, cols};
+
+    std::cout << "graph: " << frozen->size() << " nodes, " << rows << " rows, chunk "
+              << cg::eval::block_rows<T>(frozen->size()) << " rows\n";
+
+    const std::size_t hw = std::max(1u, std::thread::hardware_concurrency());
+    for (std::size_t threads = 1; threads <= hw; threads *= 2) {
+        cg::eval::ThreadPool pool(threads);
+        for (int layout = 0; layout < 2; ++layout) {
+            auto start = Clock::now();
+            if (layout == 0) {
+                cg::eval::bulk_evaluate(pool, *frozen, root, table, std::span<T>(out));
+            } else {
+                cg::eval::bulk_evaluate(pool, *frozen, root, columnar, std::span<T>(out));
+            }
+            std::chrono::duration<double> elapsed = Clock::now() - start;
+            std::cout << threads << " thread(s), " << (layout == 0 ? "row-major: " : "columnar:  ")
+                      << rows / elapsed.count() << " rows/s\n";
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,160 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "cg/expression.hpp"
+#include "cg/frozen_graph.hpp"
+#include "cg/eval/bulk.hpp"
+#include "cg/opt/fast_math.hpp"
+
+// accuracy and speed of the fast_math.hpp kernels against libm: every function is swept over a few
+// input ranges, reporting the worst error in ulps and relative terms next to the throughput of
+// libm, the scalar kernel and the span kernel. the last table runs a whole graph through bulk
+// evaluation before and after opt::FastMath
+
+using Clock = std::chrono::steady_clock;
+
+struct Range {
+    std::string name;
+    double lo, hi;
+    bool logarithmic = false;
+};
+
+std::vector<double> sample(const Range& r, std::size_t n, std::mt19937_64& rng) {
+    std::vector<double> xs(n);
+    std::uniform_real_distribution<double> u(r.logarithmic ? std::log(r.lo) : r.lo, r.logarithmic ? std::log(r.hi) : r.hi);
+    for (auto& x : xs) x = r.logarithmic ? std::exp(u(rng)) : u(rng);
+    return xs;
+}
+
+double ulps(double approx, double exact) {
+    if (approx == exact) return 0.0;
+    const double ulp = std::nextafter(std::abs(exact), INFINITY) - std::abs(exact);
+    return std::abs(approx - exact) / ulp;
+}
+
+// evaluations per second of f over xs, best of a few rounds
+template<typename F>
+double throughput(F&& f, std::size_t n) {
+    double best = 0.0;
+    for (int round = 0; round < 5; ++round) {
+        auto start = Clock::now();
+        f();
+        std::chrono::duration<double> elapsed = Clock::now() - start;
+        best = std::max(best, n / elapsed.count());
+    }
+    return best;
+}
+
+volatile double sink;
+
+void report(const std::string& fn, const Range& range, const std::vector<double>& exact,
+            const std::vector<double>& scalar, const std::vector<double>& batch,
+            double libm_rate, double scalar_rate, double batch_rate) {
+    double max_ulp = 0.0, max_rel = 0.0;
+    for (std::size_t i = 0; i < exact.size(); ++i) {
+        for (double v : {scalar[i], batch[i]}) {
+            max_ulp = std::max(max_ulp, ulps(v, exact[i]));
+            max_rel = std::max(max_rel, std::abs(v - exact[i]) / std::max(std::abs(exact[i]), 1e-300));
+        }
+    }
+    std::cout << std::left << std::setw(6) << fn << std::setw(24) << range.name << std::right
+              << std::setw(12) << std::setprecision(3) << max_ulp << std::setw(12) << max_rel
+              << std::setw(10) << std::setprecision(4) << libm_rate / 1e6 << std::setw(10) << scalar_rate / 1e6
+              << std::setw(10) << batch_rate / 1e6 << "\n";
+}
+
+void unary(const std::string& fn, const Range& range, double (*libm)(double), double (*fast)(double),
+           void (*fast_batch)(std::span<const double>, std::span<double>), std::mt19937_64& rng) {
+    const std::size_t n = 1 << 20;
+    auto xs = sample(range, n, rng);
+    std::vector<double> exact(n), scalar(n), batch(n);
+
+    double libm_rate = throughput([&] { for (std::size_t i = 0; i < n; ++i) exact[i] = libm(xs[i]); }, n);
+    double scalar_rate = throughput([&] { for (std::size_t i = 0; i < n; ++i) scalar[i] = fast(xs[i]); }, n);
+    double batch_rate = throughput([&] { fast_batch(xs, batch); }, n);
+    sink = exact[n / 2] + scalar[n / 2] + batch[n / 2];
+    report(fn, range, exact, scalar, batch, libm_rate, scalar_rate, batch_rate);
+}
+
+void binary_pow(const Range& base, const Range& exponent, std::mt19937_64& rng) {
+    const std::size_t n = 1 << 20;
+    auto as = sample(base, n, rng);
+    auto bs = sample(exponent, n, rng);
+    std::vector<double> exact(n), scalar(n), batch(n);
+
+    double libm_rate = throughput([&] { for (std::size_t i = 0; i < n; ++i) exact[i] = std::pow(as[i], bs[i]); }, n);
+    double scalar_rate = throughput([&] { for (std::size_t i = 0; i < n; ++i) scalar[i] = cg::fast::pow(as[i], bs[i]); }, n);
+    double batch_rate = throughput([&] { cg::fast::pow(as, bs, batch); }, n);
+    sink = exact[n / 2] + scalar[n / 2] + batch[n / 2];
+    report("pow", Range{base.name + " ^ " + exponent.name, 0, 0}, exact, scalar, batch, libm_rate, scalar_rate, batch_rate);
+}
+
+// exp(sin(x)) * log(y) + pow(y, cos(x)), once exact and once after the pass
+void graph_level(std::mt19937_64& rng) {
+    const std::size_t rows = 1 << 20;
+    auto xs = sample({"", -10.0, 10.0}, rows, rng);
+    auto ys = sample({"", 0.1, 10.0}, rows, rng);
+
+    auto build = [] {
+        cg::Graph<double> G;
+        auto x = cg::input(G, "x");
+        auto y = cg::input(G, "y");
+        auto f = cg::exp(cg::sin(x)) * cg::log(y) + cg::pow(y, cg::cos(x));
+        return std::pair{std::move(G), f.root()};
+    };
+
+    std::vector<double> exact(rows), approx(rows);
+    double rates[2];
+    for (int mode = 0; mode < 2; ++mode) {
+        auto [G, root] = build();
+        if (mode == 1) cg::opt::FastMath<double>(1e-7, 1e-14).run(G);
+        cg::FrozenGraph<double> frozen(std::move(G));
+        cg::eval::Columnar<double> table{{xs, ys}};
+        auto& out = mode == 0 ? exact : approx;
+        cg::eval::ThreadPool pool(1);
+        rates[mode] = throughput([&] { cg::eval::bulk_evaluate(pool, frozen, root, table, std::span<double>(out)); }, rows);
+    }
+    double max_rel = 0.0;
+    for (std::size_t i = 0; i < rows; ++i) {
+        max_rel = std::max(max_rel, std::abs(approx[i] - exact[i]) / std::max(std::abs(exact[i]), 1e-300));
+    }
+    std::cout << "\nexp(sin(x)) * log(y) + pow(y, cos(x)), " << rows << " rows, one thread:\n"
+              << "  exact " << rates[0] / 1e6 << " M rows/s, fast " << rates[1] / 1e6 << " M rows/s ("
+              << rates[1] / rates[0] << "x), max relative error " << max_rel << "\n";
+}
+
+int main() {
+    std::mt19937_64 rng(7);
+    std::cout << std::left << std::setw(6) << "fn" << std::setw(24) << "range" << std::right << std::setw(12)
+              << "max ulp" << std::setw(12) << "max rel" << std::setw(10) << "libm" << std::setw(10) << "scalar"
+              << std::setw(10) << "span" << "   (M evals/s)\n";
+
+    auto exp_ = [](double x) { return std::exp(x); };
+    auto log_ = [](double x) { return std::log(x); };
+    auto sin_ = [](double x) { return std::sin(x); };
+    auto cos_ = [](double x) { return std::cos(x); };
+    using Batch = void (*)(std::span<const double>, std::span<double>);
+    using Scalar = double (*)(double);
+
+    for (const auto& r : {Range{"[-1, 1]", -1, 1}, Range{"[-700, 700]", -700, 700}}) {
+        unary("exp", r, exp_, static_cast<Scalar>(cg::fast::exp), static_cast<Batch>(cg::fast::exp), rng);
+    }
+    for (const auto& r : {Range{"[0.5, 2]", 0.5, 2}, Range{"[1e-300, 1e300] log", 1e-300, 1e300, true}}) {
+        unary("log", r, log_, static_cast<Scalar>(cg::fast::log), static_cast<Batch>(cg::fast::log), rng);
+    }
+    for (const auto& r : {Range{"[-pi, pi]", -M_PI, M_PI}, Range{"[-1e5, 1e5]", -1e5, 1e5}}) {
+        unary("sin", r, sin_, static_cast<Scalar>(cg::fast::sin), static_cast<Batch>(cg::fast::sin), rng);
+        unary("cos", r, cos_, static_cast<Scalar>(cg::fast::cos), static_cast<Batch>(cg::fast::cos), rng);
+    }
+    binary_pow(Range{"[0.1, 10]", 0.1, 10}, Range{"[-4, 4]", -4, 4}, rng);
+    binary_pow(Range{"[1e-3, 1e3] log", 1e-3, 1e3, true}, Range{"[-50, 50]", -50, 50}, rng);
+
+    graph_level(rng);
+    return 0;
+}
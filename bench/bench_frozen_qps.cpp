@@ -0,0 +1,88 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+#include "cg/expression.hpp"
+#include "cg/frozen_graph.hpp"
+#include "cg/eval/evaluator.hpp"
+
+// queries per second of many threads hitting one shared frozen graph,
+// against the naive evaluator that reallocates and re-sorts on every call
+
+using T = double;
+using Clock = std::chrono::steady_clock;
+
+cg::NodeID build(cg::Graph<T>& G, std::size_t ops, std::size_t inputs) {
+    std::mt19937 rng(42);
+    std::vector<cg::Expression<T>> pool;
+    for (std::size_t i = 0; i < inputs; ++i) {
+        pool.push_back(cg::input(G, "x" + std::to_string(i)));
+    }
+    for (std::size_t i = 0; i < ops; ++i) {
+        auto a = pool[rng() % pool.size()];
+        auto b = pool[pool.size() - 1 - rng() % std::min<std::size_t>(pool.size(), 16)];
+        switch (rng() % 5) {
+            case 0: pool.push_back(a + b); break;
+            case 1: pool.push_back(a * b); break;
+            case 2: pool.push_back(a - b * 0.5); break;
+            case 3: pool.push_back(cg::sin(a) + b); break;
+            default: pool.push_back(a / (b * b + 1.0)); break;
+        }
+    }
+    return pool.back().root();
+}
+
+template<typename F>
+double qps(std::size_t threads, std::size_t calls_per_thread, F&& call) {
+    std::atomic<bool> go{false};
+    std::vector<std::thread> workers;
+    for (std::size_t t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t] {
+            while (!go.load(std::memory_order_acquire)) {}
+            double sink = 0.0;
+            for (std::size_t i = 0; i < calls_per_thread; ++i) {
+                sink += call(t, i);
+            }
+            volatile double keep = sink; (void)keep;
+        });
+    }
+    auto start = Clock::now();
+    go.store(true, std::memory_order_release);
+    for (auto& w : workers) w.join();
+    std::chrono::duration<double> elapsed = Clock::now() - start;
+    return static_cast<double>(threads * calls_per_thread) / elapsed.count();
+}
+
+int main() {
+    constexpr std::size_t inputs = 8;
+    constexpr std::size_t calls = 2000;
+
+    cg::Graph<T> G;
+    auto root = build(G, 2000, inputs);
+
+    cg::Context<T> ctx;
+    for (std::size_t i = 0; i < inputs; ++i) ctx["x" + std::to_string(i)] = 0.5 + i;
+
+    cg::Evaluator<T, cg::eval::NaiveEvaluator> naive;
+    double naive_qps = qps(1, calls, [&](std::size_t, std::size_t) { return naive.evaluate(G, root, ctx); });
+
+    auto frozen = cg::freeze(std::move(G));
+    std::vector<T> row(frozen->inputs().size());
+    for (std::size_t s = 0; s < row.size(); ++s) row[s] = ctx.at(frozen->input_name(s));
+
+    std::cout << "graph: " << frozen->size() << " nodes\n";
+    std::cout << "naive, 1 thread: " << naive_qps << " qps\n";
+
+    const std::size_t hw = std::max(1u, std::thread::hardware_concurrency());
+    double base = 0.0;
+    for (std::size_t threads = 1; threads <= hw; threads *= 2) {
+        double q = qps(threads, calls, [&](std::size_t, std::size_t) { return frozen->evaluate(root, row); });
+        if (threads == 1) base = q;
+        std::cout << "frozen, " << threads << " thread(s): " << q << " qps"
+                  << " (x" << q / base << " vs 1 thread)\n";
+    }
+    return 0;
+}
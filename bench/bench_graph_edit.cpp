@@ -0,0 +1,65 @@
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <queue>
+#include <random>
+#include <vector>
+#include "cg/expression.hpp"
+
+// cost of hot-patching one formula inside a growing graph: a rewire plus its incremental order
+// repair against the full kahn sort every edit used to need before the order could be trusted
+
+using Clock = std::chrono::steady_clock;
+
+// what topological_sort did before the graph maintained its order
+std::vector<cg::NodeID> kahn(const cg::Graph<double>& G) {
+    std::vector<std::size_t> indegree(G.size(), 0);
+    for (std::size_t i = 0; i < G.size(); ++i) indegree[i] = G.node(cg::NodeID{i}).inputs().size();
+    std::queue<std::size_t> q;
+    for (std::size_t i = 0; i < G.size(); ++i) if (indegree[i] == 0) q.push(i);
+    std::vector<cg::NodeID> sorted;
+    sorted.reserve(G.size());
+    while (!q.empty()) {
+        const std::size_t u = q.front();
+        q.pop();
+        sorted.push_back(cg::NodeID{u});
+        for (auto v : G.consumers(cg::NodeID{u})) if (--indegree[v.index()] == 0) q.push(v.index());
+    }
+    return sorted;
+}
+
+int main() {
+    std::cout << std::setw(10) << "nodes" << std::setw(16) << "rewire (us)" << std::setw(16) << "kahn (us)" << "\n";
+    for (std::size_t formulas : {100, 1000, 10000, 100000}) {
+        // many small independent formulas over a shared pool of inputs, like a pricing sheet
+        cg::Graph<double> G;
+        std::vector<cg::Expression<double>> inputs, roots;
+        for (int i = 0; i < 16; ++i) inputs.push_back(cg::input(G, "x" + std::to_string(i)));
+        std::mt19937 rng(3);
+        for (std::size_t f = 0; f < formulas; ++f) {
+            auto a = inputs[rng() % 16], b = inputs[rng() % 16];
+            roots.push_back(cg::exp(a * 0.5) + b * double(f) - cg::sin(a + b));
+        }
+
+        // point a node of an old formula at the root of a newer one, which forces a reorder
+        const std::size_t edits = 10000;
+        auto start = Clock::now();
+        for (std::size_t e = 0; e < edits; ++e) {
+            const std::size_t old = rng() % (formulas / 2), young = formulas / 2 + rng() % (formulas / 2);
+            const cg::NodeID target = G.node(roots[old].root()).inputs()[0];
+            G.rewire(target, 1, roots[young].root());
+            G.rewire(target, 1, inputs[e % 16].root());
+        }
+        std::chrono::duration<double, std::micro> rewire = (Clock::now() - start) / (2.0 * edits);
+
+        const std::size_t sorts = std::max<std::size_t>(1, 1000000 / G.size());
+        start = Clock::now();
+        std::size_t sink = 0;
+        for (std::size_t s = 0; s < sorts; ++s) sink += kahn(G).size();
+        std::chrono::duration<double, std::micro> sort = (Clock::now() - start) / double(sorts);
+
+        std::cout << std::setw(10) << G.size() << std::setw(16) << rewire.count() << std::setw(16) << sort.count()
+                  << (sink ? "" : " ") << "\n";
+    }
+    return 0;
+}
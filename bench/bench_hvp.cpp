@@ -0,0 +1,94 @@
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "cg/expression.hpp"
+#include "cg/ad/hessian.hpp"
+#include "cg/eval/evaluator.hpp"
+
+// hessian-vector products three ways on the same function:
+//   single sweep    ad::hvp, one forward pass seeded with v and one reverse sweep of dual adjoints
+//   per direction   one Dual<Dual> evaluation per input (e_j seeded on the outer tangent)
+//   finite diff     central differences of gradients, 2n first-order Dual evaluations
+
+using T = double;
+using DD = cg::ad::HyperDual<T>;
+using Clock = std::chrono::steady_clock;
+
+// a coupled sum over neighbours, so the hessian is banded but not diagonal
+template<typename V>
+cg::NodeID build(cg::Graph<V>& G, std::size_t n) {
+    std::vector<cg::Expression<V>> x;
+    for (std::size_t i = 0; i < n; ++i) x.push_back(cg::input(G, "x" + std::to_string(i)));
+    auto f = cg::sin(x[0] * x[1]);
+    for (std::size_t i = 1; i + 1 < n; ++i) {
+        f = f + cg::exp(x[i] * x[i + 1] * V(0.1)) + x[i] * x[i] * x[i - 1];
+    }
+    return f.root();
+}
+
+template<typename F>
+double time_it(int reps, F&& f) {
+    auto start = Clock::now();
+    for (int r = 0; r < reps; ++r) f();
+    std::chrono::duration<double> elapsed = Clock::now() - start;
+    return elapsed.count() / reps * 1e6;
+}
+
+int main() {
+    for (std::size_t n : {8, 32, 128}) {
+        cg::Graph<DD> H;
+        auto root2 = build(H, n);
+        cg::Graph<cg::Dual<T>> G;
+        auto root1 = build(G, n);
+
+        cg::Context<T> at, v;
+        for (std::size_t i = 0; i < n; ++i) {
+            at["x" + std::to_string(i)] = 0.3 + 0.01 * i;
+            v["x" + std::to_string(i)] = 1.0 / (1.0 + i);
+        }
+
+        std::vector<T> sweep, per_dir(n), fd(n);
+        double t_sweep = time_it(20, [&] { sweep = cg::ad::hvp(H, root2, at, v).hv; });
+
+        cg::Evaluator<DD, cg::eval::NaiveEvaluator> nested;
+        double t_dir = time_it(20, [&] {
+            for (std::size_t j = 0; j < n; ++j) {
+                cg::Context<DD> ctx;
+                for (std::size_t i = 0; i < n; ++i) {
+                    auto name = "x" + std::to_string(i);
+                    ctx[name] = DD(cg::Dual<T>(at[name], v[name]), cg::Dual<T>(i == j ? 1.0 : 0.0, 0.0));
+                }
+                per_dir[j] = nested.evaluate(H, root2, ctx).d.d;
+            }
+        });
+
+        cg::Evaluator<cg::Dual<T>, cg::eval::NaiveEvaluator> first;
+        const T h = 1e-5;
+        double t_fd = time_it(20, [&] {
+            for (std::size_t j = 0; j < n; ++j) {
+                T grad[2];
+                for (int side = 0; side < 2; ++side) {
+                    cg::Context<cg::Dual<T>> ctx;
+                    for (std::size_t i = 0; i < n; ++i) {
+                        auto name = "x" + std::to_string(i);
+                        ctx[name] = cg::Dual<T>(at[name] + (side ? h : -h) * v[name], i == j ? 1.0 : 0.0);
+                    }
+                    grad[side] = first.evaluate(G, root1, ctx).d;
+                }
+                fd[j] = (grad[1] - grad[0]) / (2 * h);
+            }
+        });
+
+        double err_dir = 0.0, err_fd = 0.0;
+        for (std::size_t j = 0; j < n; ++j) {
+            err_dir = std::max(err_dir, std::abs(per_dir[j] - sweep[j]));
+            err_fd = std::max(err_fd, std::abs(fd[j] - sweep[j]));
+        }
+
+        std::cout << "n = " << n << ": single sweep " << t_sweep << " us, per direction " << t_dir
+                  << " us (max diff " << err_dir << "), finite diff " << t_fd << " us (max err " << err_fd << ")\n";
+    }
+    return 0;
+}
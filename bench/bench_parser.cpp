@@ -0,0 +1,52 @@
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "cg/parse/parser.hpp"
+
+// tokens per second of bulk parsing many generated formulas into one shared graph
+
+using T = double;
+using Clock = std::chrono::steady_clock;
+
+std::string formula(std::mt19937& rng, int depth) {
+    static const char* names[] = {"spot", "strike", "rate", "vol", "t", "q"};
+    static const char* fns[] = {"sin", "cos", "exp", "log", "sqrt"};
+    if (depth == 0 || rng() % 4 == 0) {
+        if (rng() % 3 == 0) return std::to_string(rng() % 1000 / 100.0);
+        return names[rng() % 6];
+    }
+    switch (rng() % 6) {
+        case 0: return formula(rng, depth - 1) + " + " + formula(rng, depth - 1);
+        case 1: return formula(rng, depth - 1) + " * " + formula(rng, depth - 1);
+        case 2: return "(" + formula(rng, depth - 1) + " - " + formula(rng, depth - 1) + ") / 2";
+        case 3: return std::string(fns[rng() % 5]) + "(" + formula(rng, depth - 1) + ")";
+        case 4: return "pow(" + formula(rng, depth - 1) + ", 2)";
+        default: return "-" + formula(rng, depth - 1) + " ^ 0.5";
+    }
+}
+
+int main() {
+    std::mt19937 rng(3);
+    std::vector<std::string> texts;
+    std::size_t bytes = 0;
+    for (int i = 0; i < 20000; ++i) {
+        texts.push_back(formula(rng, 7));
+        bytes += texts.back().size();
+    }
+    std::vector<std::string_view> views(texts.begin(), texts.end());
+    std::vector<cg::NodeID> roots(views.size());
+
+    for (int round = 0; round < 3; ++round) {
+        cg::Graph<T> G;
+        cg::parse::Parser<T> parser(G);
+        auto start = Clock::now();
+        parser.parse_all(views, roots);
+        std::chrono::duration<double> elapsed = Clock::now() - start;
+        std::cout << views.size() << " formulas, " << parser.tokens() << " tokens, " << bytes / 1024 << " KiB -> "
+                  << G.size() << " shared nodes: " << parser.tokens() / elapsed.count() / 1e6 << " M tokens/s\n";
+    }
+    return 0;
+}
@@ -0,0 +1,88 @@
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+#include "cg/eval/service.hpp"
+#include "cg/parse/parser.hpp"
+
+// load generator for eval::BatchingService: closed-loop clients each keep one request in flight
+// (submit, wait, repeat) and record its latency. reports p50/p99 and requests per second with
+// batching off and with a couple of latency budgets
+
+using Clock = std::chrono::steady_clock;
+
+struct Result {
+    double p50, p99, throughput, batch;
+};
+
+Result load(const std::shared_ptr<const cg::FrozenGraph<double>>& frozen, cg::NodeID root,
+            cg::eval::ServiceOptions options, std::size_t clients, std::size_t per_client) {
+    cg::eval::BatchingService<double> service(frozen, options);
+    std::vector<std::vector<double>> latencies(clients);
+    std::vector<std::thread> threads;
+    auto start = Clock::now();
+    for (std::size_t c = 0; c < clients; ++c) {
+        threads.emplace_back([&, c] {
+            std::mt19937_64 rng(c);
+            std::uniform_real_distribution<double> u(-2.0, 2.0);
+            latencies[c].reserve(per_client);
+            for (std::size_t i = 0; i < per_client; ++i) {
+                const double row[] = {u(rng), u(rng)};
+                auto sent = Clock::now();
+                volatile double v = service.submit(root, row).get();
+                (void)v;
+                latencies[c].push_back(std::chrono::duration<double, std::micro>(Clock::now() - sent).count());
+            }
+        });
+    }
+    for (auto& t : threads) t.join();
+    std::chrono::duration<double> elapsed = Clock::now() - start;
+
+    std::vector<double> all;
+    for (auto& l : latencies) all.insert(all.end(), l.begin(), l.end());
+    std::sort(all.begin(), all.end());
+    const auto stats = service.stats();
+    return {all[all.size() / 2], all[all.size() * 99 / 100], all.size() / elapsed.count(),
+            double(stats.requests) / double(stats.batches)};
+}
+
+int main() {
+    cg::Graph<double> G;
+    cg::parse::Parser<double> parser(G);
+    const cg::NodeID root = parser.parse(
+        "(1 + x * (0.5 + x * (0.25 + x * (0.125 + x * 0.0625)))) / (1 + y * y * (0.3 + y * 0.1))"
+        " + exp(-0.1 * y) * cos(3 * x) * (x * x - y * y) / (1 + x * x + y * y)"
+        " - log(1 + x * x) * 0.01");
+    auto frozen = cg::freeze(std::move(G));
+
+    struct Mode {
+        const char* name;
+        cg::eval::ServiceOptions options;
+    };
+    const Mode modes[] = {
+        {"off", {std::chrono::microseconds(0), 0, false}},
+        {"on, 50us", {std::chrono::microseconds(50), 0, true}},
+        {"on, 200us", {std::chrono::microseconds(200), 0, true}},
+    };
+
+    std::cout << frozen->size() << " nodes, " << std::thread::hardware_concurrency() << " hardware threads\n"
+              << std::left << std::setw(10) << "clients" << std::setw(12) << "batching" << std::right
+              << std::setw(12) << "p50 (us)" << std::setw(12) << "p99 (us)" << std::setw(14) << "req/s"
+              << std::setw(12) << "avg batch" << "\n";
+    for (std::size_t clients : {1, 8, 64}) {
+        const std::size_t per_client = 40000 / clients;
+        // a batch as large as the client count fills up without waiting out the budget
+        const Mode sized{"on, full", {std::chrono::microseconds(200), clients, true}};
+        for (const auto* mode : {&modes[0], &modes[1], &modes[2], &sized}) {
+            const auto r = load(frozen, root, mode->options, clients, per_client);
+            std::cout << std::left << std::setw(10) << clients << std::setw(12) << mode->name << std::right
+                      << std::fixed << std::setprecision(1) << std::setw(12) << r.p50 << std::setw(12) << r.p99
+                      << std::setw(14) << std::setprecision(0) << r.throughput << std::setw(12)
+                      << std::setprecision(1) << r.batch << "\n";
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,56 @@
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <random>
+#include <string>
+#include "cg/expression.hpp"
+#include "cg/frozen_graph.hpp"
+#include "cg/eval/streaming.hpp"
+
+// streams a generated columnar file through a graph and reports throughput,
+// pass the number of rows as the first argument (default 2^22)
+
+using T = double;
+using Clock = std::chrono::steady_clock;
+namespace fs = std::filesystem;
+
+int main(int argc, char** argv) {
+    const std::size_t rows = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : (1u << 22);
+    const fs::path dir = fs::temp_directory_path();
+    const std::string in_path = (dir / "cg_bench_stream_in.cgc").string();
+    const std::string out_path = (dir / "cg_bench_stream_out.cgc").string();
+
+    {
+        auto file = cg::io::ColumnarFile<T>::create(in_path, rows, {"a", "b", "c"});
+        std::mt19937 rng(1);
+        std::uniform_real_distribution<T> dist(0.1, 3.0);
+        for (std::size_t c = 0; c < 3; ++c) {
+            for (auto& v : file.column(c)) v = dist(rng);
+        }
+        file.file().sync();
+    }
+
+    cg::Graph<T> G;
+    auto a = cg::input(G, "a");
+    auto b = cg::input(G, "b");
+    auto c = cg::input(G, "c");
+    auto price = cg::exp(-a * 0.05) * cg::log(b + 1.0) + cg::sqrt(c) * b;
+    auto risk = price * price / (a + c);
+    const cg::NodeID roots[] = {price.root(), risk.root()};
+    auto frozen = cg::freeze(std::move(G));
+
+    for (std::size_t block : {1u << 12, 1u << 16, 1u << 20}) {
+        auto start = Clock::now();
+        auto stats = cg::eval::stream_evaluate(*frozen, roots, {"price", "risk"}, in_path, out_path,
+                                               {.block_rows = block});
+        std::chrono::duration<double> elapsed = Clock::now() - start;
+        const double mb = static_cast<double>(stats.rows * (3 + 2) * sizeof(T)) / (1 << 20);
+        std::cout << "block " << block << " rows: " << stats.rows / elapsed.count() << " rows/s, "
+                  << mb / elapsed.count() << " MiB/s through the mappings\n";
+    }
+
+    fs::remove(in_path);
+    fs::remove(out_path);
+    return 0;
+}
@@ -0,0 +1,74 @@
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+#include "cg/tensor.hpp"
+#include "cg/frozen_graph.hpp"
+#include "cg/eval/evaluator.hpp"
+#include "cg/analysis/allocations.hpp"
+
+// heap allocations per evaluation of a small dense layer stack over Tensor values: the frozen graph
+// writing into reused slots against the by-value path every op used to take
+
+CG_DEFINE_COUNTING_ALLOCATOR()
+
+using M = cg::Tensor<double>;
+using Clock = std::chrono::steady_clock;
+
+M random_matrix(std::size_t rows, std::size_t cols, std::mt19937& rng) {
+    std::uniform_real_distribution<double> u(-0.5, 0.5);
+    M m(rows, cols);
+    for (std::size_t i = 0; i < m.size(); ++i) m[i] = u(rng);
+    return m;
+}
+
+int main() {
+    const std::size_t width = 64, layers = 4, evaluations = 20000;
+    std::mt19937 rng(11);
+
+    // h_{k+1} = tanh-ish(W_k h_k + b_k), loss = sum(h * h)
+    cg::Graph<M> G;
+    auto h = cg::input(G, "x");
+    for (std::size_t k = 0; k < layers; ++k) {
+        auto W = cg::constant(G, random_matrix(width, width, rng));
+        auto b = cg::constant(G, random_matrix(width, 1, rng));
+        auto z = cg::matmul(W, h) + b;
+        h = z / cg::sqrt(z * z + cg::constant(G, M(1.0)));
+    }
+    auto loss = cg::sum(h * h);
+    cg::FrozenGraph<M> frozen(std::move(G));
+
+    const M x = random_matrix(width, 1, rng);
+    const M inputs[] = {x};
+    M out;
+
+    auto run = [&](const char* name, auto&& evaluate) {
+        const auto warmup = cg::analysis::count_allocations(evaluate); // first call sizes every slot
+
+        cg::analysis::AllocationScope scope;
+        auto start = Clock::now();
+        for (std::size_t i = 0; i < evaluations; ++i) evaluate();
+        std::chrono::duration<double> elapsed = Clock::now() - start;
+        const auto steady = scope.stats();
+
+        std::cout << "  " << name << ": first call " << warmup.allocations << " allocations, steady state "
+                  << double(steady.allocations) / evaluations << " per evaluation (peak " << steady.peak_bytes
+                  << " bytes), " << evaluations / elapsed.count() << " evals/s\n";
+    };
+
+    std::cout << frozen.size() << " nodes, " << layers << " layers of " << width << "x" << width << "\n";
+    run("frozen, in place ", [&] { frozen.evaluate(loss.root(), inputs, out); });
+
+    // what every node did before evaluate_into: a fresh value out of each op
+    std::vector<M> values(frozen.size());
+    run("frozen, by value ", [&] {
+        values[frozen.inputs()[0].index()] = x;
+        for (auto id : frozen.ops()) values[id.index()] = frozen.node(id).evaluate_from_cache(values);
+        out = values[loss.root().index()];
+    });
+
+    cg::Evaluator<M, cg::eval::NaiveEvaluator> naive;
+    cg::Context<M> ctx{{"x", x}};
+    run("naive evaluator  ", [&] { out = naive.evaluate(frozen.graph(), loss.root(), ctx); });
+    return 0;
+}
@@ -0,0 +1,98 @@
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+#include "cg/expression.hpp"
+#include "cg/eval/bulk.hpp"
+#include "cg/eval/tiled.hpp"
+
+// a large graph over many rows, node-at-a-time (bulk_evaluate with its default cache-sized block
+// and with a long one) against the cache-blocked TiledPlan. column traffic is the modeled bytes per
+// row written to a value column and read back: every node's for the node-at-a-time sweeps, only the
+// boundary values' for the tiled plan, whose other columns live in a tile buffer that stays in cache.
+// times the measured rate that's the bandwidth the columns ask of the memory hierarchy
+
+using Clock = std::chrono::steady_clock;
+
+template<typename F>
+double rows_per_second(F&& f, std::size_t rows) {
+    double best = 0.0;
+    for (int round = 0; round < 3; ++round) {
+        auto start = Clock::now();
+        f();
+        std::chrono::duration<double> elapsed = Clock::now() - start;
+        best = std::max(best, rows / elapsed.count());
+    }
+    return best;
+}
+
+int main() {
+    const auto& caches = cg::eval::cache_sizes();
+    std::cout << "caches: l1d " << caches.l1d / 1024 << "K, l2 " << caches.l2 / 1024 << "K, l3 " << caches.l3 / 1024
+              << "K\n";
+
+    for (std::size_t formulas : {200, 2000, 8000}) {
+        // a sheet of small formulas over shared inputs, each folded into a running total and some
+        // reusing an earlier formula's result
+        cg::Graph<double> G;
+        std::vector<cg::Expression<double>> inputs, results;
+        for (int i = 0; i < 8; ++i) inputs.push_back(cg::input(G, "x" + std::to_string(i)));
+        std::mt19937 rng(9);
+        auto total = cg::constant(G, 0.0);
+        for (std::size_t f = 0; f < formulas; ++f) {
+            auto a = inputs[rng() % 8], b = inputs[rng() % 8];
+            auto t = a * (0.5 + 0.001 * f) - b;
+            auto u = t * t + a * 0.25;
+            auto v = cg::sqrt(u * u + 1.0) / (b * b + 1.0 + 0.01 * f) + t * u;
+            if (!results.empty() && f % 4 == 0) v = v + results[rng() % results.size()] * 0.5;
+            results.push_back(v);
+            total = total + v * (1.0 / (f + 1));
+        }
+        cg::FrozenGraph<double> frozen(std::move(G));
+
+        const std::size_t rows = std::max<std::size_t>(1 << 14, (std::size_t{1} << 28) / frozen.size() / 8 / 8 * 8);
+        std::vector<std::vector<double>> columns(8, std::vector<double>(rows));
+        std::uniform_real_distribution<double> u(-1.0, 1.0);
+        for (auto& c : columns) for (auto& v : c) v = u(rng);
+        cg::eval::Columnar<double> table;
+        for (auto& c : columns) table.columns.emplace_back(c);
+        std::vector<double> reference(rows), out(rows);
+
+        cg::eval::ThreadPool pool(1);
+        const cg::NodeID roots[] = {total.root()};
+        cg::eval::TiledPlan<double> plan(frozen, roots);
+
+        const std::size_t plain_block = cg::eval::block_rows<double>(frozen.size());
+        const double plain = rows_per_second([&] {
+            cg::eval::bulk_evaluate(pool, frozen, total.root(), table, std::span<double>(reference));
+        }, rows);
+        const double long_block = rows_per_second([&] {
+            cg::eval::bulk_evaluate(pool, frozen, total.root(), table, std::span<double>(out), {plan.tile_rows()});
+        }, rows);
+        const double tiled = rows_per_second([&] {
+            cg::eval::tiled_evaluate(pool, plan, total.root(), table, std::span<double>(out));
+        }, rows);
+
+        double max_diff = 0.0;
+        for (std::size_t r = 0; r < rows; ++r) max_diff = std::max(max_diff, std::abs(out[r] - reference[r]));
+
+        const double node_bytes = 2.0 * frozen.size() * sizeof(double);
+        const double boundary_bytes = 2.0 * plan.boundary_values() * sizeof(double);
+        auto line = [&](const char* name, double rate, double bytes) {
+            std::cout << "  " << std::left << std::setw(30) << name << std::right << std::setw(9) << std::setprecision(4)
+                      << rate / 1e6 << " M rows/s" << std::setw(10) << std::setprecision(4) << bytes / 1024
+                      << " KiB/row column traffic, " << std::setprecision(3) << bytes * rate / 1e9 << " GB/s\n";
+        };
+        std::cout << "\n" << frozen.size() << " nodes, " << rows << " rows, one thread. tiled: " << plan.partitions().size()
+                  << " partitions, " << plan.tile_rows() << " row tiles, " << plan.block_rows() << " row blocks, "
+                  << plan.boundary_values() << " boundary values in " << plan.wide_slots() << " slots\n";
+        line(("bulk, " + std::to_string(plain_block) + " row blocks").c_str(), plain, node_bytes);
+        line(("bulk, " + std::to_string(plan.tile_rows()) + " row blocks").c_str(), long_block, node_bytes);
+        line("tiled", tiled, boundary_bytes);
+        std::cout << "  tiled vs bulk: " << tiled / plain << "x, vs long blocks: " << tiled / long_block
+                  << "x, max abs difference " << max_diff << "\n";
+    }
+    return 0;
+}
@@ -0,0 +1,95 @@
+#pragma once
+#include "../graph.hpp"
+#include "../dual.hpp"
+#include "../eval/policies.hpp"
+
+#include <algorithm>
+#include <span>
+#include <vector>
+
+namespace cg::ad {
+
+    template<typename T>
+    using HyperDual = Dual<Dual<T>>;
+
+    template<typename T>
+    struct HessianVectorProduct {
+        std::vector<NodeID> inputs; // input node of every component below, in id order
+        T value{};                  // f(x)
+        T directional{};            // grad f(x) . v
+        std::vector<T> gradient;    // grad f(x)
+        std::vector<T> hv;          // H(x) v
+    };
+
+    // hessian-vector product of a scalar output by forward-over-reverse differentiation.
+    // one forward pass carries the direction v on the inner tangent, then a reverse sweep propagates
+    // Dual<T> adjoints: their value part accumulates the gradient, their tangent part H v.
+    // the graph has no symbolic derivatives, so each node's local partials come from re-evaluating
+    // just that node with the outer tangent seeded on one of its inputs. that costs one node
+    // evaluation per distinct input edge and keeps memory at one value and one adjoint per node.
+    // inputs missing from `v` get a zero component
+    template<typename T>
+    HessianVectorProduct<T> hvp(const Graph<HyperDual<T>>& G, NodeID output,
+                                const Context<T>& at, const Context<T>& v) {
+        using D = HyperDual<T>;
+
+        G.node(output); // throws for a removed id
+        HessianVectorProduct<T> result;
+        std::vector<NodeID> ops;
+        const auto order = G.topological_sort();
+        for (auto id : order) {
+            if (G.node(id).kind() == "input") {
+                result.inputs.push_back(id);
+            } else {
+                ops.push_back(id);
+            }
+        }
+
+        std::vector<D> values(G.size());
+        for (auto id : result.inputs) {
+            const auto& input = static_cast<const InputNode<D>&>(G.node(id));
+            auto x = at.find(input.name());
+            if (x == at.end()) {
+                throw std::runtime_error("missing value for input variable: " + input.name());
+            }
+            auto dir = v.find(input.name());
+            values[id.index()] = D(Dual<T>(x->second, dir == v.end() ? T(0) : dir->second), Dual<T>(T(0), T(0)));
+        }
+        for (auto id : ops) G.node(id).evaluate_into(values, values[id.index()]);
+
+        const Dual<T> zero(T(0), T(0));
+        std::vector<Dual<T>> adjoint(G.size(), zero);
+        adjoint[output.index()] = Dual<T>(T(1), T(0));
+        std::vector<NodeID> seen;
+        D partial;
+        for (auto it = ops.rbegin(); it != ops.rend(); ++it) {
+            const auto& node = G.node(*it);
+            const Dual<T> bar = adjoint[it->index()];
+            if (bar == zero) continue;
+            // x * x seeds x once, the node's value already depends on it through both edges
+            seen.clear();
+            for (auto dep : node.inputs()) {
+                if (std::find(seen.begin(), seen.end(), dep) != seen.end()) continue;
+                seen.push_back(dep);
+                D& slot = values[dep.index()];
+                slot.d = Dual<T>(T(1), T(0));
+                node.evaluate_into(values, partial);
+                slot.d = zero;
+                adjoint[dep.index()] = adjoint[dep.index()] + bar * partial.d;
+            }
+        }
+
+        const D& out = values[output.index()];
+        result.value = out.value.value;
+        result.directional = out.value.d;
+        const std::size_t n = result.inputs.size();
+        result.gradient.resize(n);
+        result.hv.resize(n);
+        for (std::size_t j = 0; j < n; ++j) {
+            result.gradient[j] = adjoint[result.inputs[j].index()].value;
+            result.hv[j] = adjoint[result.inputs[j].index()].d;
+        }
+        return result;
+    }
+
+} // namespace cg::ad
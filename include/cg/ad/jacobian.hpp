@@ -0,0 +1,225 @@
+#pragma once
+#include "../graph.hpp"
+#include "../dual.hpp"
+#include "../eval/policies.hpp"
+
+#include <cstdint>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace cg::ad {
+
+    // compressed sparse row matrix, row r's entries live in [row_ptr[r], row_ptr[r + 1])
+    template<typename T>
+    struct CsrMatrix {
+        std::size_t rows = 0;
+        std::size_t cols = 0;
+        std::vector<std::size_t> row_ptr;
+        std::vector<std::size_t> col_idx;
+        std::vector<T> values;
+
+        std::size_t nonzeros() const noexcept { return col_idx.size(); }
+
+        // structural zeros read as T{}
+        T at(std::size_t r, std::size_t c) const {
+            for (std::size_t k = row_ptr[r]; k < row_ptr[r + 1]; ++k) {
+                if (col_idx[k] == c) return values[k];
+            }
+            return T{};
+        }
+    };
+
+    // which inputs each output structurally depends on. columns are the graph's input nodes in id order
+    struct Sparsity {
+        std::vector<NodeID> inputs;
+        CsrMatrix<std::uint8_t> pattern; // values unused, only the structure matters
+
+        std::size_t rows() const noexcept { return pattern.rows; }
+        std::size_t cols() const noexcept { return pattern.cols; }
+    };
+
+    namespace detail {
+
+        // the nodes `outputs` depend on, themselves included, in execution order
+        template<Numeric T>
+        std::vector<NodeID> cone(const Graph<T>& G, std::span<const NodeID> outputs) {
+            std::vector<bool> needed(G.size(), false);
+            std::vector<NodeID> stack;
+            for (auto out : outputs) {
+                if (!G.alive(out)) {
+                    throw std::runtime_error("node " + std::to_string(out.index()) + " is not in the graph");
+                }
+                if (!needed[out.index()]) {
+                    needed[out.index()] = true;
+                    stack.push_back(out);
+                }
+            }
+            while (!stack.empty()) {
+                const NodeID id = stack.back();
+                stack.pop_back();
+                for (auto dep : G.node(id).inputs()) {
+                    if (!needed[dep.index()]) {
+                        needed[dep.index()] = true;
+                        stack.push_back(dep);
+                    }
+                }
+            }
+            std::vector<NodeID> order;
+            for (auto id : G.topological_sort()) {
+                if (needed[id.index()]) order.push_back(id);
+            }
+            return order;
+        }
+
+        // sparsity() with the outputs' cone at hand, only the cone is walked
+        template<Numeric T>
+        Sparsity sparsity(const Graph<T>& G, std::span<const NodeID> outputs, std::span<const NodeID> cone) {
+            Sparsity s;
+            std::vector<std::size_t> column(G.size(), 0);
+            for (size_t i = 0; i < G.size(); ++i) {
+                if (G.alive(NodeID{i}) && G.node(NodeID{i}).kind() == "input") {
+                    column[i] = s.inputs.size();
+                    s.inputs.push_back(NodeID{i});
+                }
+            }
+
+            // one bitset of reachable inputs per node, built bottom-up
+            const std::size_t words = (s.inputs.size() + 63) / 64;
+            std::vector<std::uint64_t> deps(G.size() * words, 0);
+            for (auto id : cone) {
+                const auto& node = G.node(id);
+                std::uint64_t* mine = deps.data() + id.index() * words;
+                if (node.kind() == "input") {
+                    const std::size_t c = column[id.index()];
+                    mine[c / 64] |= std::uint64_t{1} << (c % 64);
+                }
+                for (auto dep : node.inputs()) {
+                    const std::uint64_t* theirs = deps.data() + dep.index() * words;
+                    for (std::size_t w = 0; w < words; ++w) mine[w] |= theirs[w];
+                }
+            }
+
+            s.pattern.rows = outputs.size();
+            s.pattern.cols = s.inputs.size();
+            s.pattern.row_ptr.push_back(0);
+            for (auto out : outputs) {
+                const std::uint64_t* bits = deps.data() + out.index() * words;
+                for (std::size_t c = 0; c < s.inputs.size(); ++c) {
+                    if (bits[c / 64] >> (c % 64) & 1) {
+                        s.pattern.col_idx.push_back(c);
+                    }
+                }
+                s.pattern.row_ptr.push_back(s.pattern.col_idx.size());
+            }
+            s.pattern.values.assign(s.pattern.col_idx.size(), 1);
+            return s;
+        }
+
+    } // namespace detail
+
+    // throws when an output isn't a node of G
+    template<Numeric T>
+    Sparsity sparsity(const Graph<T>& G, std::span<const NodeID> outputs) {
+        return detail::sparsity(G, outputs, detail::cone(G, outputs));
+    }
+
+    // greedy colouring of the columns so that no two columns of one colour share a row,
+    // i.e. columns of a colour are structurally orthogonal and can be seeded in the same pass.
+    // returns colour per column, the number of colours is max + 1
+    inline std::vector<std::size_t> color_columns(const Sparsity& s) {
+        const auto& p = s.pattern;
+
+        std::vector<std::vector<std::size_t>> rows_of(p.cols);
+        for (std::size_t r = 0; r < p.rows; ++r) {
+            for (std::size_t k = p.row_ptr[r]; k < p.row_ptr[r + 1]; ++k) {
+                rows_of[p.col_idx[k]].push_back(r);
+            }
+        }
+
+        constexpr std::size_t none = static_cast<std::size_t>(-1);
+        std::vector<std::size_t> color(p.cols, none);
+        std::vector<std::size_t> forbidden; // forbidden[k] == c marks colour k as taken for column c
+
+        for (std::size_t c = 0; c < p.cols; ++c) {
+            for (std::size_t r : rows_of[c]) {
+                for (std::size_t k = p.row_ptr[r]; k < p.row_ptr[r + 1]; ++k) {
+                    const std::size_t other = color[p.col_idx[k]];
+                    if (other == none) continue;
+                    if (other >= forbidden.size()) forbidden.resize(other + 1, none);
+                    forbidden[other] = c;
+                }
+            }
+            std::size_t k = 0;
+            while (k < forbidden.size() && forbidden[k] == c) ++k;
+            color[c] = k;
+        }
+        return color;
+    }
+
+    template<typename T>
+    struct SparseJacobian {
+        CsrMatrix<T> J;              // rows follow the outputs, columns follow `inputs`
+        std::vector<NodeID> inputs;  // input node of every column
+        std::vector<std::size_t> colors;
+        std::size_t passes = 0;      // forward sweeps it took, one per colour
+    };
+
+    // jacobian of `outputs` with respect to every input node, evaluated at `at`.
+    // inputs that never appear together in an output share a colour and get seeded in the same
+    // forward pass, so it takes about as many passes as the colouring has colours instead of one per input
+    template<typename T>
+    SparseJacobian<T> jacobian(const Graph<Dual<T>>& G, std::span<const NodeID> outputs, const Context<T>& at) {
+        using D = Dual<T>;
+
+        const auto cone = detail::cone(G, outputs);
+        auto s = detail::sparsity(G, outputs, cone);
+        SparseJacobian<T> result;
+        result.colors = color_columns(s);
+        result.inputs = s.inputs;
+        for (auto c : result.colors) result.passes = std::max(result.passes, c + 1);
+
+        result.J.rows = s.pattern.rows;
+        result.J.cols = s.pattern.cols;
+        result.J.row_ptr = s.pattern.row_ptr;
+        result.J.col_idx = s.pattern.col_idx;
+        result.J.values.assign(s.pattern.col_idx.size(), T{});
+
+        std::vector<T> point(s.inputs.size());
+        for (std::size_t c = 0; c < s.inputs.size(); ++c) {
+            const auto& input = static_cast<const InputNode<D>&>(G.node(s.inputs[c]));
+            auto it = at.find(input.name());
+            if (it == at.end()) {
+                throw std::runtime_error("missing value for input variable: " + input.name());
+            }
+            point[c] = it->second;
+        }
+
+        // every pass sweeps only what the outputs read, inputs are seeded rather than evaluated
+        std::vector<NodeID> ops;
+        for (auto id : cone) {
+            if (G.node(id).kind() != "input") ops.push_back(id);
+        }
+        std::vector<D> values(G.size());
+
+        for (std::size_t pass = 0; pass < result.passes; ++pass) {
+            for (std::size_t c = 0; c < s.inputs.size(); ++c) {
+                values[s.inputs[c].index()] = D(point[c], result.colors[c] == pass ? T(1) : T(0));
+            }
+            for (auto id : ops) {
+                values[id.index()] = G.node(id).evaluate_from_cache(values);
+            }
+            // within a row only one column carries this colour, so the tangent is exactly its entry
+            for (std::size_t r = 0; r < result.J.rows; ++r) {
+                for (std::size_t k = result.J.row_ptr[r]; k < result.J.row_ptr[r + 1]; ++k) {
+                    if (result.colors[result.J.col_idx[k]] == pass) {
+                        result.J.values[k] = values[outputs[r].index()].d;
+                    }
+                }
+            }
+        }
+        return result;
+    }
+
+} // namespace cg::ad
@@ -0,0 +1,126 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <utility>
+
+namespace cg::analysis {
+
+    // heap traffic seen by the calling thread while a scope was open
+    struct AllocationStats {
+        std::size_t allocations = 0;
+        std::size_t deallocations = 0;
+        std::size_t bytes = 0;      // total requested
+        std::size_t peak_bytes = 0; // most live at once, on top of what was live when the scope opened
+    };
+
+    namespace detail {
+
+        struct AllocationCounter {
+            std::size_t allocations = 0, deallocations = 0, bytes = 0;
+            std::ptrdiff_t live = 0, peak = 0; // live goes negative freeing memory from before
+        };
+
+        inline thread_local AllocationCounter counter;
+        inline bool counting_hooked = false; // set by CG_DEFINE_COUNTING_ALLOCATOR
+
+        inline void record_allocation(std::size_t n) noexcept {
+            auto& c = counter;
+            ++c.allocations;
+            c.bytes += n;
+            c.live += static_cast<std::ptrdiff_t>(n);
+            c.peak = std::max(c.peak, c.live);
+        }
+
+        inline void record_deallocation(std::size_t n) noexcept {
+            auto& c = counter;
+            ++c.deallocations;
+            c.live -= static_cast<std::ptrdiff_t>(n);
+        }
+
+        // every block carries its size in front so delete knows what it frees.
+        // the header is as wide as the alignment, so the pointer handed out keeps it
+        inline void* counted_allocate(std::size_t n, std::size_t align) {
+            const std::size_t header = std::max<std::size_t>(align, 2 * sizeof(std::size_t));
+            const std::size_t total = (header + std::max<std::size_t>(n, 1) + align - 1) / align * align;
+            void* raw = align > alignof(std::max_align_t) ? std::aligned_alloc(align, total) : std::malloc(total);
+            if (!raw) throw std::bad_alloc();
+            auto* p = static_cast<unsigned char*>(raw) + header;
+            reinterpret_cast<std::size_t*>(p)[-1] = n;
+            reinterpret_cast<std::size_t*>(p)[-2] = header;
+            record_allocation(n);
+            return p;
+        }
+
+        inline void counted_free(void* p) noexcept {
+            if (!p) return;
+            const std::size_t n = static_cast<std::size_t*>(p)[-1], header = static_cast<std::size_t*>(p)[-2];
+            record_deallocation(n);
+            std::free(static_cast<unsigned char*>(p) - header);
+        }
+
+    } // namespace detail
+
+    // whether this program replaced operator new with CG_DEFINE_COUNTING_ALLOCATOR; without it
+    // every scope reports zeros
+    inline bool counting_allocations() noexcept { return detail::counting_hooked; }
+
+    // counts the calling thread's allocations between construction and stats(). scopes nest,
+    // an inner scope's allocations show up in the outer one too
+    class AllocationScope {
+    public:
+        AllocationScope() noexcept : start_(detail::counter), outer_peak_(detail::counter.peak) {
+            detail::counter.peak = detail::counter.live;
+        }
+
+        AllocationScope(const AllocationScope&) = delete;
+        AllocationScope& operator=(const AllocationScope&) = delete;
+
+        ~AllocationScope() {
+            detail::counter.peak = std::max(outer_peak_, detail::counter.peak);
+        }
+
+        AllocationStats stats() const noexcept {
+            const auto& now = detail::counter;
+            return {now.allocations - start_.allocations, now.deallocations - start_.deallocations,
+                    now.bytes - start_.bytes, static_cast<std::size_t>(now.peak - start_.live)};
+        }
+
+    private:
+        detail::AllocationCounter start_;
+        std::ptrdiff_t outer_peak_;
+    };
+
+    // f() under a fresh scope
+    template<typename F>
+    AllocationStats count_allocations(F&& f) {
+        AllocationScope scope;
+        std::forward<F>(f)();
+        return scope.stats();
+    }
+
+} // namespace cg::analysis
+
+// replaces the global operator new and delete with counting versions. expand it once, at namespace
+// scope, in one translation unit of a test or benchmark binary. not meant for production builds:
+// every allocation grows by a small header and touches a thread_local
+#define CG_DEFINE_COUNTING_ALLOCATOR()                                                                             \
+    static const bool cg_counting_allocator_hooked = (cg::analysis::detail::counting_hooked = true);              \
+    void* operator new(std::size_t n) { return cg::analysis::detail::counted_allocate(n, alignof(std::max_align_t)); } \
+    void* operator new[](std::size_t n) { return cg::analysis::detail::counted_allocate(n, alignof(std::max_align_t)); } \
+    void* operator new(std::size_t n, std::align_val_t a) {                                                       \
+        return cg::analysis::detail::counted_allocate(n, static_cast<std::size_t>(a));                            \
+    }                                                                                                              \
+    void* operator new[](std::size_t n, std::align_val_t a) {                                                     \
+        return cg::analysis::detail::counted_allocate(n, static_cast<std::size_t>(a));                            \
+    }                                                                                                              \
+    void operator delete(void* p) noexcept { cg::analysis::detail::counted_free(p); }                              \
+    void operator delete[](void* p) noexcept { cg::analysis::detail::counted_free(p); }                            \
+    void operator delete(void* p, std::size_t) noexcept { cg::analysis::detail::counted_free(p); }                 \
+    void operator delete[](void* p, std::size_t) noexcept { cg::analysis::detail::counted_free(p); }               \
+    void operator delete(void* p, std::align_val_t) noexcept { cg::analysis::detail::counted_free(p); }            \
+    void operator delete[](void* p, std::align_val_t) noexcept { cg::analysis::detail::counted_free(p); }          \
+    void operator delete(void* p, std::size_t, std::align_val_t) noexcept { cg::analysis::detail::counted_free(p); } \
+    void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { cg::analysis::detail::counted_free(p); }
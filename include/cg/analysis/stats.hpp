@@ -0,0 +1,208 @@
+#pragma once
+#include "../graph.hpp"
+#include "../scan.hpp"
+
+#include <algorithm>
+#include <map>
+#include <set>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+namespace cg::analysis {
+
+    // relative cost of a single application of an op, keyed by its symbol (see ops.hpp)
+    struct CostTable {
+        std::unordered_map<std::string, double> costs;
+        double fallback = 1.0;
+
+        // rough cycle counts for a scalar double on a modern x86 core
+        static CostTable defaults() {
+            return CostTable{{
+                {"+", 1.0}, {"-", 1.0}, {"*", 1.0}, {"~", 1.0},
+                {"/", 4.0}, {"sqrt", 6.0},
+                {"sin", 20.0}, {"cos", 20.0}, {"exp", 20.0}, {"log", 20.0},
+                {"pow", 40.0},
+            }};
+        }
+
+        double operator()(std::string_view symbol) const {
+            auto it = costs.find(std::string(symbol));
+            return it == costs.end() ? fallback : it->second;
+        }
+    };
+
+    // ops that end up in libm rather than a single instruction (sqrt is one, if a slow one)
+    inline bool is_transcendental(std::string_view symbol) noexcept {
+        return symbol == "sin" || symbol == "cos" || symbol == "exp" ||
+               symbol == "log" || symbol == "pow";
+    }
+
+    enum class Execution { serial, parallel, batched };
+
+    struct GraphStats {
+        std::size_t nodes = 0;
+        std::size_t inputs = 0;
+        std::size_t constants = 0;
+        std::size_t ops = 0;
+
+        // critical path length counted in op levels (inputs and constants sit at level 0)
+        std::size_t depth = 0;
+        // number of nodes per level, width[0] holds the leaves
+        std::vector<std::size_t> width;
+        std::size_t max_width = 0;
+
+        std::map<std::string, std::size_t> op_counts; // by op symbol
+        std::size_t flops = 0;
+        std::size_t transcendentals = 0;
+
+        // call and scan nodes run a whole subgraph each, they count here instead of in flops.
+        // the cost of a call is its body's total_cost, a scan's is that times the sequence length.
+        // outputs of one call (per-step nodes of one scan) share a single run, which is charged once
+        std::size_t calls = 0;
+        std::size_t scans = 0;
+        double call_cost = 0.0;
+        double scan_cost = 0.0;
+
+        double total_cost = 0.0;         // sum of per-op costs, i.e. serial work
+        double critical_path_cost = 0.0; // heaviest root-to-leaf chain, i.e. best parallel span
+
+        std::size_t node_bytes = 0;  // node objects plus the owning pointer table
+        std::size_t value_bytes = 0; // one evaluation's value buffer
+
+        // nodes consumed by more than one other node
+        std::size_t shared_nodes = 0;
+        // size of the expression trees hanging off the sinks divided by the dag size,
+        // 1.0 means cse found nothing to share
+        double sharing_ratio = 1.0;
+
+        // average amount of independent work per level
+        double parallelism() const noexcept {
+            return critical_path_cost > 0.0 ? total_cost / critical_path_cost : 1.0;
+        }
+    };
+
+    template<Numeric T>
+    GraphStats analyze(const Graph<T>& G, const CostTable& table = CostTable::defaults()) {
+        GraphStats s;
+        s.nodes = G.live();
+        s.value_bytes = G.size() * sizeof(T);
+
+        auto order = G.topological_sort();
+
+        std::vector<std::size_t> level(G.size(), 0);
+        std::vector<double> path_cost(G.size(), 0.0);
+        std::vector<double> tree_size(G.size(), 1.0);
+        std::vector<std::size_t> consumers(G.size(), 0);
+
+        // a body is analyzed once however many nodes call it
+        std::unordered_map<const void*, double> body_costs;
+        auto body_cost = [&](const Function<T>& fn) {
+            auto [it, fresh] = body_costs.try_emplace(&fn, 0.0);
+            if (fresh) it->second = analyze(fn.body().graph(), table).total_cost;
+            return it->second;
+        };
+        // subgraph runs charged so far: function, scanned sequence, whether it's a final state, inputs
+        std::set<std::tuple<const void*, const void*, bool, std::vector<NodeID>>> runs;
+        auto inputs_of = [](const Node<T>& node) {
+            return std::vector<NodeID>(node.inputs().begin(), node.inputs().end());
+        };
+
+        for (auto id : order) {
+            const auto& node = G.node(id);
+            const size_t idx = id.index();
+            s.node_bytes += node.footprint() + sizeof(std::unique_ptr<Node<T>>);
+
+            if (node.kind() == "input") {
+                ++s.inputs;
+            } else if (node.kind() == "const") {
+                ++s.constants;
+            } else {
+                ++s.ops;
+                double cost;
+                if (auto* call = dynamic_cast<const CallNode<T>*>(&node)) {
+                    ++s.calls;
+                    cost = body_cost(*call->function());
+                    if (runs.insert({call->function().get(), nullptr, true, inputs_of(node)}).second) {
+                        s.call_cost += cost;
+                        s.total_cost += cost;
+                    }
+                } else if (auto* scan = dynamic_cast<const ScanNode<T>*>(&node)) {
+                    ++s.scans;
+                    cost = body_cost(*scan->step()) * static_cast<double>(scan->sequence()->size());
+                    const bool last = scan->at() == ScanNode<T>::final_state;
+                    if (runs.insert({scan->step().get(), scan->sequence().get(), last, inputs_of(node)}).second) {
+                        s.scan_cost += cost;
+                        s.total_cost += cost;
+                    }
+                } else {
+                    const auto symbol = node.label();
+                    cost = table(symbol);
+                    ++s.op_counts[symbol];
+                    if (is_transcendental(symbol)) {
+                        ++s.transcendentals;
+                    } else {
+                        ++s.flops;
+                    }
+                    s.total_cost += cost;
+                }
+
+                size_t lvl = 0;
+                double longest = 0.0;
+                for (auto dep : node.inputs()) {
+                    lvl = std::max(lvl, level[dep.index()]);
+                    longest = std::max(longest, path_cost[dep.index()]);
+                    tree_size[idx] += tree_size[dep.index()];
+                    ++consumers[dep.index()];
+                }
+                level[idx] = lvl + 1;
+                path_cost[idx] = longest + cost;
+            }
+
+            if (level[idx] >= s.width.size()) {
+                s.width.resize(level[idx] + 1, 0);
+            }
+            ++s.width[level[idx]];
+            s.depth = std::max(s.depth, level[idx]);
+            s.critical_path_cost = std::max(s.critical_path_cost, path_cost[idx]);
+        }
+
+        double expanded = 0.0;
+        for (auto id : order) {
+            const size_t i = id.index();
+            if (consumers[i] > 1) ++s.shared_nodes;
+            if (consumers[i] == 0) expanded += tree_size[i];
+        }
+        if (s.nodes > 0) {
+            s.sharing_ratio = expanded / static_cast<double>(s.nodes);
+        }
+        if (!s.width.empty()) {
+            s.max_width = *std::max_element(s.width.begin(), s.width.end());
+        }
+        return s;
+    }
+
+    // rows from which a node-at-a-time sweep pays for its per-node virtual call and column setup,
+    // eight of the 8-row groups block_rows() hands out
+    inline constexpr std::size_t batch_min_rows = 64;
+
+    // CostTable units are roughly cycles. waking the pool's workers for one evaluation costs on the
+    // order of 1e4, so ask for ten times that in work to keep the overhead around 10%
+    inline constexpr double parallel_min_cost = 1e5;
+
+    // fewer independent ops per level than this leaves most of the workers of a small pool idle
+    inline constexpr double parallel_min_width = 4.0;
+
+    // picks an execution strategy from the graph's shape and the number of rows to push through it:
+    // many rows amortize per-node dispatch best when evaluated node-at-a-time over blocks,
+    // a single row only benefits from threads when there's enough independent work per level
+    inline Execution suggest_execution(const GraphStats& s, std::size_t rows = 1,
+                                       double min_parallel_cost = parallel_min_cost) {
+        if (rows >= batch_min_rows) return Execution::batched;
+        if (s.total_cost >= min_parallel_cost && s.parallelism() >= parallel_min_width) return Execution::parallel;
+        return Execution::serial;
+    }
+
+} // namespace cg::analysis
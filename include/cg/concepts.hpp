@@ -1,5 +1,6 @@
 #pragma once
 #include <concepts>
+#include <span>
 
 namespace cg {
 
@@ -33,4 +34,21 @@ namespace cg {
         { o(x, y) } -> std::same_as<T>;
     };
 
+    // optional whole-column hooks: an operation that has one gets it called by evaluate_batch
+    // instead of being applied row by row, e.g. the vectorized kernels of fast_math.hpp
+
+    template <typename O, typename T>
+    concept BatchUnaryOperation =
+        requires (const O o, std::span<const T> x, std::span<T> out)
+    {
+        o.batch(x, out);
+    };
+
+    template <typename O, typename T>
+    concept BatchBinaryOperation =
+        requires (const O o, std::span<const T> x, std::span<const T> y, std::span<T> out)
+    {
+        o.batch(x, y, out);
+    };
+
 } // namespace cg
\ No newline at end of file
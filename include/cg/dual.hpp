@@ -1,9 +1,15 @@
 #pragma once
 #include <cmath>
+#include <functional>
 #include <iostream>
+#include <type_traits>
+
+#include "identical.hpp"
 
 namespace cg {
 
+    // value + derivative pair. T may itself be a Dual, which nests tangents for higher derivatives:
+    // Dual<Dual<double>> carries f, two first derivatives and the mixed second derivative
     template<typename T>
     struct Dual {
         T value; // value
@@ -11,6 +17,10 @@ namespace cg {
 
         Dual(T v = 0, T d = 0) : value(v), d(d) {}
 
+        // a plain number is a constant at any depth of nesting, Dual<Dual<double>> x = 2.0 works
+        template<typename S> requires std::is_arithmetic_v<S>
+        Dual(S v) : value(v), d(0) {}
+
         Dual operator+(const Dual& x) const {
             return {value + x.value, d + x.d};
         }
@@ -34,31 +44,78 @@ namespace cg {
         auto operator<=>(const Dual& x) const = default;
     };
 
-    template<typename T> Dual<T> operator+(T a, const Dual<T>& x) { return {a + x.value, x.d}; }
-    template<typename T> Dual<T> operator+(const Dual<T>& x, T a) { return {x.value + a, x.d}; }
-    template<typename T> Dual<T> operator-(T a, const Dual<T>& x) { return {a - x.value, -x.d}; }
-    template<typename T> Dual<T> operator-(const Dual<T>& x, T a) { return {x.value - a, x.d}; }
-    template<typename T> Dual<T> operator*(T a, const Dual<T>& x) { return {a * x.value, a * x.d}; }
-    template<typename T> Dual<T> operator*(const Dual<T>& x, T a) { return {x.value * a, x.d * a}; }
+    // mixed with a plain T. the scalar isn't deduced, so anything converting to T works too:
+    // 2.0 * x and x / 2.0 compile for Dual<Dual<double>> as well, the 2.0 becomes the inner Dual<double>
+    template<typename T> Dual<T> operator+(std::type_identity_t<T> a, const Dual<T>& x) { return {a + x.value, x.d}; }
+    template<typename T> Dual<T> operator+(const Dual<T>& x, std::type_identity_t<T> a) { return {x.value + a, x.d}; }
+    template<typename T> Dual<T> operator-(std::type_identity_t<T> a, const Dual<T>& x) { return {a - x.value, -x.d}; }
+    template<typename T> Dual<T> operator-(const Dual<T>& x, std::type_identity_t<T> a) { return {x.value - a, x.d}; }
+    template<typename T> Dual<T> operator*(std::type_identity_t<T> a, const Dual<T>& x) { return {a * x.value, a * x.d}; }
+    template<typename T> Dual<T> operator*(const Dual<T>& x, std::type_identity_t<T> a) { return {x.value * a, x.d * a}; }
+    template<typename T> Dual<T> operator/(std::type_identity_t<T> a, const Dual<T>& x) {
+        return {a / x.value, -(a * x.d) / (x.value * x.value)};
+    }
+    template<typename T> Dual<T> operator/(const Dual<T>& x, std::type_identity_t<T> a) { return {x.value / a, x.d / a}; }
+
+    template<typename T>
+    bool identical(const Dual<T>& a, const Dual<T>& b) {
+        return identical(a.value, b.value) && identical(a.d, b.d);
+    }
 
     template<typename T>
     std::ostream& operator<<(std::ostream& os, const Dual<T>& x) {
         return os << "{value: " << x.value << ", d: " << x.d << "}";
     }
 
+    // the math below calls sin/cos/... unqualified so that a nested Dual value picks up these overloads
+
     template<typename T> Dual<T> sin(const Dual<T>& x) {
-        return {std::sin(x.value), std::cos(x.value) * x.d};
+        using std::sin, std::cos;
+        return {sin(x.value), cos(x.value) * x.d};
     }
 
     template<typename T> Dual<T> cos(const Dual<T>& x) {
-        return {std::cos(x.value), -std::sin(x.value) * x.d};
+        using std::sin, std::cos;
+        return {cos(x.value), -sin(x.value) * x.d};
     }
 
     template<typename T> Dual<T> exp(const Dual<T>& x) {
-        T e = std::exp(x.value);
+        using std::exp;
+        T e = exp(x.value);
         return {e, e * x.d};
     }
 
-    // TODO: add log(x) ?
+    template<typename T> Dual<T> log(const Dual<T>& x) {
+        using std::log;
+        return {log(x.value), x.d / x.value};
+    }
 
-}
\ No newline at end of file
+    template<typename T> Dual<T> sqrt(const Dual<T>& x) {
+        using std::sqrt;
+        T r = sqrt(x.value);
+        return {r, x.d / (r + r)};
+    }
+
+    // d(a^b) = b a^(b-1) da + a^b log(a) db, the log term only shows up when the exponent actually varies
+    // so constant exponents keep working for non-positive bases
+    template<typename T> Dual<T> pow(const Dual<T>& base, const Dual<T>& exponent) {
+        using std::pow, std::log;
+        T p = pow(base.value, exponent.value);
+        T d = exponent.value * pow(base.value, exponent.value - T(1)) * base.d;
+        if (exponent.d != T(0)) {
+            d = d + p * log(base.value) * exponent.d;
+        }
+        return {p, d};
+    }
+
+} // namespace cg
+
+// lets Dual constants take part in cse (ConstantNode hashes its value)
+template<typename T>
+struct std::hash<cg::Dual<T>> {
+    std::size_t operator()(const cg::Dual<T>& x) const noexcept {
+        std::size_t seed = std::hash<T>{}(x.value);
+        seed ^= std::hash<T>{}(x.d) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+        return seed;
+    }
+};
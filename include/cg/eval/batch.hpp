@@ -0,0 +1,40 @@
+#pragma once
+#include "../graph.hpp"
+
+#include <algorithm>
+#include <span>
+#include <type_traits>
+
+namespace cg::eval {
+
+    // bytes of value buffer we try to keep resident while sweeping a block of rows
+    inline constexpr std::size_t default_cache_bytes = 256 * 1024;
+
+    // rows per block so that one block's value buffer (every node times every row) fits the cache,
+    // kept a multiple of 8 so the per-node loops stay vector friendly
+    template<typename T>
+    std::size_t block_rows(std::size_t nodes, std::size_t cache_bytes = default_cache_bytes) {
+        const std::size_t per_row = std::max<std::size_t>(nodes, 1) * sizeof(T);
+        const std::size_t rows = std::clamp<std::size_t>(cache_bytes / per_row, 8, 4096);
+        return rows / 8 * 8;
+    }
+
+    // node-at-a-time sweep over a block of rows: every node in `ops` reads its children's rows
+    // through columns[child.index()] and writes its own. inputs are expected to be filled in already
+    template<Numeric T>
+    void evaluate_block(const Graph<T>& G, std::span<const NodeID> ops,
+                        std::type_identity_t<std::span<T* const>> columns, std::size_t rows) {
+        for (auto id : ops) {
+            G.node(id).evaluate_batch(columns, std::span<T>(columns[id.index()], rows));
+        }
+    }
+
+    // points columns[i] at row 0 of node i in a node-major buffer with `stride` rows per node
+    template<typename T>
+    void bind_columns(std::span<T> values, std::size_t stride, std::span<T*> columns) {
+        for (std::size_t i = 0; i < columns.size(); ++i) {
+            columns[i] = values.data() + i * stride;
+        }
+    }
+
+} // namespace cg::eval
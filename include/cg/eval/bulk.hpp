@@ -0,0 +1,123 @@
+#pragma once
+#include "../frozen_graph.hpp"
+#include "batch.hpp"
+#include "scratch.hpp"
+#include "thread_pool.hpp"
+
+#include <algorithm>
+#include <span>
+#include <vector>
+
+namespace cg::eval {
+
+    // rows x cols table, data[r * cols + c] is row r's value for input slot c
+    template<typename T>
+    struct RowMajor {
+        std::span<const T> data;
+        std::size_t cols = 0;
+
+        std::size_t rows() const noexcept { return cols ? data.size() / cols : 0; }
+    };
+
+    // one contiguous column per input slot, all of the same length
+    template<typename T>
+    struct Columnar {
+        std::vector<std::span<const T>> columns;
+
+        std::size_t rows() const noexcept { return columns.empty() ? 0 : columns.front().size(); }
+    };
+
+    struct BulkOptions {
+        std::size_t chunk_rows = 0; // 0 picks a block that keeps the value buffer in cache
+        std::size_t cache_bytes = default_cache_bytes;
+    };
+
+    namespace detail {
+
+        template<typename T>
+        void gather(const RowMajor<T>& table, std::size_t slot, std::size_t first, std::span<T> dst) {
+            const T* src = table.data.data() + first * table.cols + slot;
+            for (std::size_t r = 0; r < dst.size(); ++r) {
+                dst[r] = src[r * table.cols];
+            }
+        }
+
+        template<typename T>
+        void gather(const Columnar<T>& table, std::size_t slot, std::size_t first, std::span<T> dst) {
+            std::copy_n(table.columns[slot].data() + first, dst.size(), dst.begin());
+        }
+
+        // the table has a column for every input slot of G, all of them equally long
+        template<typename T, typename Table>
+        void check_table(const FrozenGraph<T>& G, const Table& table) {
+            std::size_t cols;
+            if constexpr (requires { table.cols; }) {
+                cols = table.cols;
+            } else {
+                cols = table.columns.size();
+                for (const auto& c : table.columns) {
+                    if (c.size() != table.rows()) {
+                        throw std::runtime_error("columns of a columnar table must have the same length");
+                    }
+                }
+            }
+            if (cols < G.inputs().size()) {
+                throw std::runtime_error("expected " + std::to_string(G.inputs().size()) + " input columns, got " +
+                                         std::to_string(cols));
+            }
+        }
+
+        template<typename T, typename Table>
+        void check(const FrozenGraph<T>& G, const Table& table, std::span<T> out) {
+            check_table(G, table);
+            if (out.size() < table.rows()) {
+                throw std::runtime_error("output span is shorter than the number of rows");
+            }
+        }
+
+        // the same for a table evaluated at `root`, which has to be a live node of G
+        template<typename T, typename Table>
+        void check(const FrozenGraph<T>& G, NodeID root, const Table& table, std::span<T> out) {
+            G.check_roots(std::span<const NodeID>(&root, 1));
+            check(G, table, out);
+        }
+
+    } // namespace detail
+
+    // evaluates `root` for every row of `table` and writes row r's result to out[r].
+    // rows are split into cache-sized chunks that the pool's threads evaluate node-at-a-time,
+    // each thread in its own scratch buffer. input columns follow G.inputs()' slot order
+    template<Numeric T, typename Table>
+    void bulk_evaluate(ThreadPool& pool, const FrozenGraph<T>& G, NodeID root,
+                       const Table& table, std::span<T> out, BulkOptions options = {}) {
+        detail::check(G, root, table, out);
+
+        const std::size_t rows = table.rows();
+        const std::size_t chunk = options.chunk_rows ? options.chunk_rows : block_rows<T>(G.size(), options.cache_bytes);
+        const std::size_t chunks = (rows + chunk - 1) / chunk;
+
+        pool.parallel_for(chunks, [&](std::size_t c) {
+            const std::size_t first = c * chunk;
+            const std::size_t n = std::min(chunk, rows - first);
+
+            auto frame = Scratch<T>::acquire(G.size() * chunk);
+            auto pointers = Scratch<T*>::acquire(G.size());
+            bind_columns(frame.values(), chunk, pointers.values());
+            auto columns = pointers.values();
+
+            for (std::size_t s = 0; s < G.inputs().size(); ++s) {
+                detail::gather(table, s, first, std::span<T>(columns[G.inputs()[s].index()], n));
+            }
+            evaluate_block(G.graph(), G.ops(), columns, n);
+            std::copy_n(columns[root.index()], n, out.begin() + first);
+        });
+    }
+
+    // same, on the process-wide default_pool()
+    template<Numeric T, typename Table>
+    void bulk_evaluate(const FrozenGraph<T>& G, NodeID root, const Table& table, std::span<T> out,
+                       BulkOptions options = {}) {
+        bulk_evaluate(default_pool(), G, root, table, out, options);
+    }
+
+} // namespace cg::eval
@@ -1,6 +1,8 @@
 #pragma once
 #include "policies.hpp"
 
+#include <concepts>
+
 namespace cg {
 
     // compile-time strategy to avoid vtable dispatching
@@ -13,6 +15,11 @@ namespace cg {
             return policy_(G, root, ctx);
         }
 
+        eval::EvaluationMemory memory(const Graph<T>& G) const
+            requires requires { { P::memory(G) } -> std::same_as<eval::EvaluationMemory>; } {
+            return P::memory(G);
+        }
+
     private:
         P policy_;
 
@@ -0,0 +1,72 @@
+#pragma once
+#include "policies.hpp"
+#include "../ops.hpp"
+#include "../fast_math.hpp"
+
+#include <concepts>
+
+namespace cg::eval {
+
+    // NaiveEvaluator with the approximate kernels in place of libm, the graph itself is left alone.
+    // handy to try the fast mode on a shared graph or to compare both modes on one graph; for
+    // repeated evaluation run opt::FastMath once instead, this policy re-dispatches every call
+    struct FastMathEvaluator {
+        double tolerance = 1e-7;          // relative, ops whose documented bound exceeds it stay exact
+        double absolute_tolerance = 0.0;  // lets sin and cos through, they have no relative bound
+
+        template<Numeric T>
+        static EvaluationMemory memory(const Graph<T>& G) { return NaiveEvaluator::memory(G); }
+
+        template<Numeric T>
+        T operator()(const Graph<T>& G, NodeID root, const Context<T>& ctx) const {
+            if constexpr (!std::floating_point<T>) {
+                return NaiveEvaluator{}(G, root, ctx);
+            } else {
+                std::vector<T> values(G.size());
+                for (auto id : G.topological_sort()) {
+                    const auto& node = G.node(id);
+                    if (node.kind() == "input") {
+                        const auto& input = static_cast<const InputNode<T>&>(node);
+                        auto it = ctx.find(input.name());
+                        if (it == ctx.end()) {
+                            throw std::runtime_error("missing value for input variable: " + input.name());
+                        }
+                        values[id.index()] = it->second;
+                    } else if (!approximate(node, values, values[id.index()])) {
+                        values[id.index()] = node.evaluate_from_cache(values);
+                    }
+                }
+                return values[root.index()];
+            }
+        }
+
+    private:
+        template<std::floating_point T, typename Exact, typename Fast>
+        bool unary(const Node<T>& node, const std::vector<T>& values, fast::Function f, T& out) const {
+            if (!fast::within(f, tolerance, absolute_tolerance)) return false;
+            if (auto* u = dynamic_cast<const UnaryNode<T, Exact>*>(&node)) {
+                out = Fast{}(values[u->input().index()]);
+                return true;
+            }
+            return false;
+        }
+
+        template<std::floating_point T>
+        bool approximate(const Node<T>& node, const std::vector<T>& values, T& out) const {
+            if (node.kind() == "unary") {
+                return unary<T, ops::Sin, ops::fast::Sin>(node, values, fast::Function::sin, out) ||
+                       unary<T, ops::Cos, ops::fast::Cos>(node, values, fast::Function::cos, out) ||
+                       unary<T, ops::Exp, ops::fast::Exp>(node, values, fast::Function::exp, out) ||
+                       unary<T, ops::Log, ops::fast::Log>(node, values, fast::Function::log, out);
+            }
+            if (node.kind() == "binary" && fast::within(fast::Function::pow, tolerance, absolute_tolerance)) {
+                if (auto* b = dynamic_cast<const BinaryNode<T, ops::Pow>*>(&node)) {
+                    out = ops::fast::Pow{}(values[b->left().index()], values[b->right().index()]);
+                    return true;
+                }
+            }
+            return false;
+        }
+    };
+
+} // namespace cg::eval
@@ -0,0 +1,368 @@
+#pragma once
+#include "../frozen_graph.hpp"
+#include "../ops.hpp"
+#include "batch.hpp"
+#include "bulk.hpp"
+#include "scratch.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace cg::eval {
+
+    enum class Precision : std::uint8_t { f32, f64 };
+
+    // which precision each node of a Graph<double> runs in. a node's own override wins over its
+    // label (the op symbol, e.g. "-" or "log"), which wins over the fallback
+    struct PrecisionPlan {
+        Precision fallback = Precision::f32;
+        std::unordered_map<std::string, Precision> symbols;
+        std::unordered_map<std::size_t, Precision> nodes; // keyed by NodeID::index()
+
+        PrecisionPlan& set(NodeID id, Precision p) { nodes[id.index()] = p; return *this; }
+        PrecisionPlan& set(std::string symbol, Precision p) { symbols[std::move(symbol)] = p; return *this; }
+
+        Precision operator()(NodeID id, const Node<double>& node) const {
+            if (auto it = nodes.find(id.index()); it != nodes.end()) return it->second;
+            if (auto it = symbols.find(node.label()); it != symbols.end()) return it->second;
+            return fallback;
+        }
+
+        static PrecisionPlan uniform(Precision p) {
+            PrecisionPlan plan;
+            plan.fallback = p;
+            return plan;
+        }
+
+        // float everywhere except subtraction, division and log, the ops where cancellation or a
+        // near-1 argument eats float's 24 bits first
+        static PrecisionPlan sensitive() {
+            PrecisionPlan plan;
+            plan.set("-", Precision::f64).set("/", Precision::f64).set("log", Precision::f64);
+            return plan;
+        }
+    };
+
+    // evaluates a frozen Graph<double> with float value columns wherever the plan allows.
+    // the graph is compiled once into a flat program: the ops of ops.hpp become opcodes run over
+    // whole blocks of rows in their precision (so float nodes get twice the vector lanes and half
+    // the memory traffic), a value crossing precisions is converted once per row by its producer.
+    // any other node (calls, scans, fast math, ...) runs in double through its own evaluate_batch.
+    // inputs and constants are exact in double and rounded once for float consumers.
+    // `G` must outlive this object
+    class MixedPrecision {
+    public:
+        explicit MixedPrecision(const FrozenGraph<double>& G, const PrecisionPlan& plan = {}) : G_(&G) {
+            precision_.resize(G.size(), Precision::f64);
+            std::vector<bool> f32(G.size(), false), f64(G.size(), false);
+
+            for (auto id : G.order()) {
+                const auto& node = G.node(id);
+                Instruction in{id, compile(node)};
+                if (in.code == Code::constant) in.constant = static_cast<const ConstantNode<double>&>(node).value();
+                if (in.code == Code::input) in.slot = slot_of(id);
+
+                auto deps = node.inputs();
+                if (!deps.empty()) in.a = deps[0];
+                if (deps.size() > 1) in.b = deps[1];
+
+                Precision p = Precision::f64;
+                if (in.code != Code::input && in.code != Code::constant && in.code != Code::generic) {
+                    p = plan(id, node);
+                }
+                precision_[id.index()] = p;
+                // leaves are computed in double, float copies come from rounding those
+                (p == Precision::f32 && in.code != Code::input && in.code != Code::constant ? f32 : f64)[id.index()] = true;
+                for (auto dep : deps) {
+                    (p == Precision::f32 ? f32 : f64)[dep.index()] = true;
+                }
+                program_.push_back(in);
+            }
+
+            for (auto& in : program_) {
+                in.f32 = f32[in.id.index()];
+                in.f64 = f64[in.id.index()];
+                row_bytes_ += (in.f32 ? sizeof(float) : 0) + (in.f64 ? sizeof(double) : 0);
+            }
+        }
+
+        const FrozenGraph<double>& graph() const noexcept { return *G_; }
+
+        Precision precision(NodeID id) const { return precision_.at(id.index()); }
+
+        // how many nodes compute in double (inputs and constants included)
+        std::size_t promoted() const noexcept {
+            return static_cast<std::size_t>(std::count(precision_.begin(), precision_.end(), Precision::f64));
+        }
+
+        // per evaluating thread with `options`' block size: a float and a double column per node
+        // (both are reserved whatever the plan) plus the compiled program
+        EvaluationMemory memory(BulkOptions options = {}) const {
+            const std::size_t chunk = options.chunk_rows ? options.chunk_rows : block(options.cache_bytes);
+            return {G_->size() * (chunk * (sizeof(float) + sizeof(double)) + sizeof(double*)),
+                    program_.capacity() * sizeof(Instruction) + precision_.capacity() * sizeof(Precision)};
+        }
+
+        // positional inputs, same slot order as FrozenGraph::inputs()
+        double evaluate(NodeID root, std::span<const double> inputs) const {
+            if (inputs.size() < G_->inputs().size()) {
+                throw std::runtime_error("expected " + std::to_string(G_->inputs().size()) + " input values, got " +
+                                         std::to_string(inputs.size()));
+            }
+            std::vector<std::span<const double>> columns;
+            for (std::size_t s = 0; s < G_->inputs().size(); ++s) columns.push_back(inputs.subspan(s, 1));
+            double out = 0.0;
+            evaluate(root, Columnar<double>{std::move(columns)}, std::span<double>(&out, 1));
+            return out;
+        }
+
+        // every row of `table` (RowMajor or Columnar, see bulk.hpp), out[r] receives row r's result
+        template<typename Table>
+        void evaluate(NodeID root, const Table& table, std::span<double> out, BulkOptions options = {}) const {
+            detail::check(*G_, table, out);
+            const std::size_t chunk = options.chunk_rows ? options.chunk_rows : block(options.cache_bytes);
+            const auto& result = program_[position(root)];
+            Block b(*this, chunk);
+            for (std::size_t first = 0; first < table.rows(); first += chunk) {
+                const std::size_t n = std::min(chunk, table.rows() - first);
+                run(table, first, n, b);
+                b.read(result, n, out.subspan(first, n));
+            }
+        }
+
+        // rows [first, first + rows) with every node's value widened to double, node-major:
+        // values[i * rows + r] holds node i at row first + r. the diagnostics compare these
+        template<typename Table>
+        void evaluate_nodes(const Table& table, std::size_t first, std::size_t rows, std::span<double> values) const {
+            Block b(*this, rows);
+            run(table, first, rows, b);
+            for (const auto& in : program_) {
+                b.read(in, rows, values.subspan(in.id.index() * rows, rows));
+            }
+        }
+
+    private:
+        enum class Code : std::uint8_t { input, constant, add, sub, mul, div, neg, sin, cos, exp, log, pow, sqrt, generic };
+
+        struct Instruction {
+            NodeID id;
+            Code code;
+            NodeID a{}, b{};
+            double constant = 0.0;
+            std::size_t slot = 0;
+            bool f32 = false, f64 = false; // which value columns this node fills
+        };
+
+        // the node-major float and double columns of one block of rows
+        struct Block {
+            Block(const MixedPrecision& m, std::size_t stride)
+                : floats(Scratch<float>::acquire(m.G_->size() * stride)),
+                  doubles(Scratch<double>::acquire(m.G_->size() * stride)),
+                  pointers(Scratch<double*>::acquire(m.G_->size())), stride(stride) {
+                bind_columns(doubles.values(), stride, pointers.values());
+            }
+
+            float* f(NodeID id) const noexcept { return floats.values().data() + id.index() * stride; }
+            double* d(NodeID id) const noexcept { return doubles.values().data() + id.index() * stride; }
+
+            void read(const Instruction& in, std::size_t rows, std::span<double> out) const {
+                if (in.f64) {
+                    std::copy_n(d(in.id), rows, out.begin());
+                } else {
+                    std::copy_n(f(in.id), rows, out.begin());
+                }
+            }
+
+            Scratch<float>::Frame floats;
+            Scratch<double>::Frame doubles;
+            Scratch<double*>::Frame pointers;
+            std::size_t stride;
+        };
+
+        template<typename Table>
+        void run(const Table& table, std::size_t first, std::size_t rows, Block& b) const {
+            for (const auto& in : program_) {
+                const bool single = precision_[in.id.index()] == Precision::f32;
+                switch (in.code) {
+                    case Code::input:
+                        detail::gather(table, in.slot, first, std::span<double>(b.d(in.id), rows));
+                        break;
+                    case Code::constant:
+                        std::fill_n(b.d(in.id), rows, in.constant);
+                        break;
+                    case Code::generic: {
+                        std::span<const double* const> columns(b.pointers.values().data(), G_->size());
+                        G_->node(in.id).evaluate_batch(columns, std::span<double>(b.d(in.id), rows));
+                        break;
+                    }
+                    default:
+                        if (single) {
+                            apply(in.code, b.f(in.a), b.f(in.b), b.f(in.id), rows);
+                        } else {
+                            apply(in.code, b.d(in.a), b.d(in.b), b.d(in.id), rows);
+                        }
+                }
+                // hand the value over to consumers of the other precision
+                if (single && in.f64) {
+                    std::copy_n(b.f(in.id), rows, b.d(in.id));
+                } else if (!single && in.f32) {
+                    std::copy_n(b.d(in.id), rows, b.f(in.id));
+                }
+            }
+        }
+
+        template<typename F>
+        static void apply(Code code, const F* x, const F* y, F* out, std::size_t n) {
+            using std::sin, std::cos, std::exp, std::log, std::pow, std::sqrt;
+            switch (code) {
+                case Code::add: for (std::size_t r = 0; r < n; ++r) out[r] = x[r] + y[r]; break;
+                case Code::sub: for (std::size_t r = 0; r < n; ++r) out[r] = x[r] - y[r]; break;
+                case Code::mul: for (std::size_t r = 0; r < n; ++r) out[r] = x[r] * y[r]; break;
+                case Code::div: for (std::size_t r = 0; r < n; ++r) out[r] = x[r] / y[r]; break;
+                case Code::neg: for (std::size_t r = 0; r < n; ++r) out[r] = -x[r]; break;
+                case Code::sin: for (std::size_t r = 0; r < n; ++r) out[r] = sin(x[r]); break;
+                case Code::cos: for (std::size_t r = 0; r < n; ++r) out[r] = cos(x[r]); break;
+                case Code::exp: for (std::size_t r = 0; r < n; ++r) out[r] = exp(x[r]); break;
+                case Code::log: for (std::size_t r = 0; r < n; ++r) out[r] = log(x[r]); break;
+                case Code::pow: for (std::size_t r = 0; r < n; ++r) out[r] = pow(x[r], y[r]); break;
+                case Code::sqrt: for (std::size_t r = 0; r < n; ++r) out[r] = sqrt(x[r]); break;
+                default: break;
+            }
+        }
+
+        template<typename O>
+        static bool is_unary(const Node<double>& node) { return dynamic_cast<const UnaryNode<double, O>*>(&node); }
+
+        template<typename O>
+        static bool is_binary(const Node<double>& node) { return dynamic_cast<const BinaryNode<double, O>*>(&node); }
+
+        static Code compile(const Node<double>& node) {
+            const auto kind = node.kind();
+            if (kind == "input") return Code::input;
+            if (kind == "const") return Code::constant;
+            if (kind == "binary") {
+                if (is_binary<ops::Add>(node)) return Code::add;
+                if (is_binary<ops::Sub>(node)) return Code::sub;
+                if (is_binary<ops::Mul>(node)) return Code::mul;
+                if (is_binary<ops::Div>(node)) return Code::div;
+                if (is_binary<ops::Pow>(node)) return Code::pow;
+            } else if (kind == "unary") {
+                if (is_unary<ops::Neg>(node)) return Code::neg;
+                if (is_unary<ops::Sin>(node)) return Code::sin;
+                if (is_unary<ops::Cos>(node)) return Code::cos;
+                if (is_unary<ops::Exp>(node)) return Code::exp;
+                if (is_unary<ops::Log>(node)) return Code::log;
+                if (is_unary<ops::Sqrt>(node)) return Code::sqrt;
+            }
+            return Code::generic;
+        }
+
+        std::size_t slot_of(NodeID id) const {
+            auto inputs = G_->inputs();
+            return static_cast<std::size_t>(std::find(inputs.begin(), inputs.end(), id) - inputs.begin());
+        }
+
+        std::size_t position(NodeID id) const {
+            for (std::size_t i = 0; i < program_.size(); ++i) {
+                if (program_[i].id == id) return i;
+            }
+            throw std::runtime_error("node " + std::to_string(id.index()) + " is not part of the graph");
+        }
+
+        // like block_rows, but with the columns this program actually fills
+        std::size_t block(std::size_t cache_bytes) const {
+            const std::size_t rows = std::clamp<std::size_t>(cache_bytes / std::max<std::size_t>(row_bytes_, 1), 8, 4096);
+            return rows / 8 * 8;
+        }
+
+        const FrozenGraph<double>* G_;
+        std::vector<Instruction> program_; // execution order
+        std::vector<Precision> precision_; // by node index
+        std::size_t row_bytes_ = 0;
+    };
+
+    struct NodeError {
+        NodeID id;
+        std::string label;
+        Precision precision;
+        double max_relative_error = 0.0; // against an all-double evaluation, over every row
+        double introduced = 0.0;         // the part not explained by the node's inputs being off already
+        double reference = 0.0;          // both values at the worst row
+        double value = 0.0;
+        std::size_t row = 0;
+    };
+
+    // evaluates `mixed` and the all-double graph side by side over every row of `table` and returns
+    // the `top_k` nodes with the largest relative error, worst first. a node far down the list in
+    // `introduced` but high in `max_relative_error` only inherits its error, promote upstream
+    template<typename Table>
+    std::vector<NodeError> precision_report(const MixedPrecision& mixed, const Table& table, std::size_t top_k = 10,
+                                            BulkOptions options = {}) {
+        const auto& G = mixed.graph();
+        const std::size_t n = G.size();
+        std::vector<NodeError> errors(n);
+        for (auto id : G.order()) {
+            auto& e = errors[id.index()];
+            e.id = id;
+            e.label = G.node(id).label();
+            e.precision = mixed.precision(id);
+        }
+
+        auto relative = [](double value, double reference) {
+            if (value == reference || (std::isnan(value) && std::isnan(reference))) return 0.0;
+            return std::abs(value - reference) / std::abs(reference); // inf when the reference is 0
+        };
+
+        const std::size_t chunk = options.chunk_rows ? options.chunk_rows : block_rows<double>(n, options.cache_bytes);
+        std::vector<double> approx(n * chunk), row_error(n);
+        auto frame = Scratch<double>::acquire(n * chunk);
+        auto pointers = Scratch<double*>::acquire(n);
+        bind_columns(frame.values(), chunk, pointers.values());
+        auto columns = pointers.values();
+
+        for (std::size_t first = 0; first < table.rows(); first += chunk) {
+            const std::size_t rows = std::min(chunk, table.rows() - first);
+            for (std::size_t s = 0; s < G.inputs().size(); ++s) {
+                detail::gather(table, s, first, std::span<double>(columns[G.inputs()[s].index()], rows));
+            }
+            evaluate_block(G.graph(), G.ops(), columns, rows);
+            mixed.evaluate_nodes(table, first, rows, std::span<double>(approx.data(), n * rows));
+
+            for (std::size_t r = 0; r < rows; ++r) {
+                for (auto id : G.order()) {
+                    const std::size_t i = id.index();
+                    const double reference = columns[i][r], value = approx[i * rows + r];
+                    row_error[i] = relative(value, reference);
+
+                    double inherited = 0.0;
+                    for (auto dep : G.node(id).inputs()) inherited = std::max(inherited, row_error[dep.index()]);
+                    auto& e = errors[i];
+                    e.introduced = std::max(e.introduced, row_error[i] - inherited);
+                    if (row_error[i] > e.max_relative_error) {
+                        e.max_relative_error = row_error[i];
+                        e.reference = reference;
+                        e.value = value;
+                        e.row = first + r;
+                    }
+                }
+            }
+        }
+
+        // removed nodes keep a slot but have nothing to report
+        std::vector<NodeError> report;
+        report.reserve(G.order().size());
+        for (auto id : G.order()) report.push_back(std::move(errors[id.index()]));
+        std::sort(report.begin(), report.end(), [](const NodeError& a, const NodeError& b) {
+            return a.max_relative_error > b.max_relative_error;
+        });
+        report.resize(std::min(top_k, report.size()));
+        return report;
+    }
+
+} // namespace cg::eval
@@ -5,6 +5,7 @@
 #include <unordered_map>
 #include <concepts>
 #include <stdexcept>
+#include <utility>
 
 namespace cg {
     template <typename T>
@@ -21,7 +22,21 @@ namespace cg::eval {
         { p(G, root, ctx) } -> std::convertible_to<T>;
     };
 
+    // what one evaluation allocates on top of the graph, by component. `values` counts the value
+    // objects themselves, not heap memory they own (a Tensor's elements)
+    struct EvaluationMemory {
+        std::size_t values = 0;   // one value slot per node
+        std::size_t schedule = 0; // execution order, visit flags, work stacks
+
+        std::size_t total() const noexcept { return values + schedule; }
+    };
+
     struct NaiveEvaluator {
+        template<Numeric T>
+        static EvaluationMemory memory(const Graph<T>& G) {
+            return {G.size() * sizeof(T), G.live() * sizeof(NodeID)};
+        }
+
         template<Numeric T>
         T operator()(const Graph<T>& G, NodeID root, const Context<T>& ctx) const {
             std::vector<T> values(G.size()); // storage for computed values
@@ -42,7 +57,7 @@ namespace cg::eval {
                     values[id.index()] = it->second;
                 } else {
                     // all other nodes can self-evaluate using the cache
-                    values[id.index()] = node.evaluate_from_cache(values);
+                    node.evaluate_into(values, values[id.index()]);
                 }
             }
             return values[root.index()];
@@ -51,42 +66,63 @@ namespace cg::eval {
 
 
     struct LazyEvaluator {
+        // the dfs stack is counted at its worst case, one entry per edge plus the root
+        template<Numeric T>
+        static EvaluationMemory memory(const Graph<T>& G) {
+            std::size_t edges = 0;
+            for (auto id : G.topological_sort()) edges += G.node(id).inputs().size();
+            return {G.size() * sizeof(T), G.size() / 8 + (edges + 1) * sizeof(std::pair<NodeID, bool>)};
+        }
+
         template <Numeric T>
         T operator()(const Graph<T>& G, NodeID root, const Context<T>& ctx) const {
             std::vector<T> values(G.size()); // storage for computed values
             std::vector<bool> computed(G.size(), false);
 
-            return recursive_evaluate(root, G, values, computed, ctx);
+            return depth_first_evaluate(root, G, values, computed, ctx);
         }
 
     private:
+        // dfs with an explicit stack, long chains (e.g. unrolled recurrences) would overflow the call stack
         template <Numeric T>
-        T recursive_evaluate(NodeID id, const Graph<T>& G,
-                         std::vector<T>& values, std::vector<bool>& computed,
-                         const Context<T>& ctx) const {
+        T depth_first_evaluate(NodeID root, const Graph<T>& G,
+                               std::vector<T>& values, std::vector<bool>& computed,
+                               const Context<T>& ctx) const {
 
-            size_t idx = id.index();
+            std::vector<std::pair<NodeID, bool>> stack{{root, false}}; // node, dependencies pushed
+            while (!stack.empty()) {
+                auto [id, expanded] = stack.back();
+                size_t idx = id.index();
 
-            if (computed[idx]) return values[idx];
+                if (computed[idx]) {
+                    stack.pop_back();
+                    continue;
+                }
 
-            const auto& node = G.node(id);
+                const auto& node = G.node(id);
 
-            for (auto dependency : node.inputs()) {
-                recursive_evaluate(dependency, G, values, computed, ctx);
-            }
+                if (!expanded) {
+                    stack.back().second = true;
+                    for (auto dependency : node.inputs()) {
+                        if (!computed[dependency.index()]) stack.emplace_back(dependency, false);
+                    }
+                    continue;
+                }
+                stack.pop_back();
 
-            if (node.kind() == "input") {
-                const auto& input = static_cast<const InputNode<T>&>(node);
-                auto it = ctx.find(input.name());
-                if (it == ctx.end()) {
-                    throw std::runtime_error("missing value for input variable: " + input.name());
+                if (node.kind() == "input") {
+                    const auto& input = static_cast<const InputNode<T>&>(node);
+                    auto it = ctx.find(input.name());
+                    if (it == ctx.end()) {
+                        throw std::runtime_error("missing value for input variable: " + input.name());
+                    }
+                    values[idx] = it->second;
+                } else {
+                    node.evaluate_into(values, values[idx]);
                 }
-                values[idx] = it->second;
-            } else {
-                values[idx] = node.evaluate_from_cache(values);
+                computed[idx] = true;
             }
-            computed[idx] = true;
-            return values[idx];
+            return values[root.index()];
         }
     };
 }
\ No newline at end of file
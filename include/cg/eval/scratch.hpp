@@ -0,0 +1,91 @@
+#pragma once
+#include <cstddef>
+#include <new>
+#include <span>
+#include <vector>
+
+namespace cg::eval {
+
+    inline constexpr std::size_t cache_line = 64;
+
+    // hands out whole cache lines so buffers owned by different threads never share one
+    template<typename T>
+    struct CacheAlignedAllocator {
+        using value_type = T;
+
+        CacheAlignedAllocator() noexcept = default;
+        template<typename U>
+        CacheAlignedAllocator(const CacheAlignedAllocator<U>&) noexcept {}
+
+        T* allocate(std::size_t n) {
+            return static_cast<T*>(::operator new(padded(n), std::align_val_t{cache_line}));
+        }
+
+        void deallocate(T* p, std::size_t n) noexcept {
+            ::operator delete(p, padded(n), std::align_val_t{cache_line});
+        }
+
+        template<typename U>
+        friend bool operator==(const CacheAlignedAllocator&, const CacheAlignedAllocator<U>&) noexcept {
+            return true;
+        }
+
+    private:
+        static std::size_t padded(std::size_t n) noexcept {
+            return (n * sizeof(T) + cache_line - 1) / cache_line * cache_line;
+        }
+    };
+
+    template<typename T>
+    using ScratchBuffer = std::vector<T, CacheAlignedAllocator<T>>;
+
+    // a per-thread stack of value buffers that are reused across evaluations, so the steady state
+    // neither allocates nor synchronizes. frames nest: a node that evaluates a subgraph of its own
+    // grabs the next buffer instead of clobbering the caller's
+    template<typename T>
+    class Scratch {
+    public:
+        class Frame {
+        public:
+            Frame(const Frame&) = delete;
+            Frame& operator=(const Frame&) = delete;
+            ~Frame() { --owner_.depth_; }
+
+            std::span<T> values() const noexcept { return values_; }
+
+        private:
+            friend class Scratch;
+            Frame(Scratch& owner, std::span<T> values) noexcept : owner_(owner), values_(values) {}
+
+            Scratch& owner_;
+            std::span<T> values_;
+        };
+
+        // a buffer of at least n values belonging to the calling thread, valid until the frame dies.
+        // previous contents are left as they were, callers overwrite what they read
+        static Frame acquire(std::size_t n) {
+            auto& s = local();
+            if (s.depth_ == s.buffers_.size()) {
+                s.buffers_.emplace_back();
+            }
+            auto& buffer = s.buffers_[s.depth_];
+            if (buffer.size() < n) {
+                buffer.resize(n);
+            }
+            // taken only once the resize can't throw anymore, the frame built here gives it back
+            ++s.depth_;
+            return Frame(s, std::span<T>(buffer.data(), n));
+        }
+
+    private:
+        static Scratch& local() {
+            thread_local Scratch s;
+            return s;
+        }
+
+        // moving a vector keeps its heap block, so spans handed out survive buffers_ growing
+        std::vector<ScratchBuffer<T>> buffers_;
+        std::size_t depth_ = 0;
+    };
+
+} // namespace cg::eval
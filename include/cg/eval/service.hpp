@@ -0,0 +1,188 @@
+#pragma once
+#include "../frozen_graph.hpp"
+#include "batch.hpp"
+#include "scratch.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace cg::eval {
+
+    struct ServiceOptions {
+        // longest the oldest queued request waits for others to share its sweep
+        std::chrono::microseconds latency_budget{100};
+        std::size_t max_batch = 0; // 0 picks block_rows for the graph
+        bool batching = true;      // false evaluates every request on its own, as soon as it's picked up
+    };
+
+    // an async front end for many small independent requests against one frozen graph.
+    // submit() queues a row of inputs and returns a future; a dispatcher thread waits until either
+    // max_batch requests are queued or the oldest one has used up its latency budget, then runs the
+    // whole batch as one node-at-a-time sweep (evaluate_block) and completes each future from its row.
+    // requests may ask for different roots, the sweep computes every node anyway
+    template<Numeric T>
+    class BatchingService {
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        struct Stats {
+            std::size_t requests = 0;
+            std::size_t batches = 0;
+        };
+
+        explicit BatchingService(std::shared_ptr<const FrozenGraph<T>> graph, ServiceOptions options = {})
+            : graph_(std::move(graph)), options_(options), width_(graph_->inputs().size()) {
+            if (options_.max_batch == 0) options_.max_batch = block_rows<T>(graph_->size());
+            dispatcher_ = std::thread([this] { dispatch(); });
+        }
+
+        BatchingService(const BatchingService&) = delete;
+        BatchingService& operator=(const BatchingService&) = delete;
+
+        // whatever is still queued gets evaluated before the dispatcher exits
+        ~BatchingService() {
+            {
+                std::lock_guard lock(m_);
+                stop_ = true;
+            }
+            arrived_.notify_one();
+            dispatcher_.join();
+        }
+
+        // positional inputs in graph().inputs() slot order, copied before returning.
+        // a bad root or a short row throws here, evaluation errors are delivered through the future
+        std::future<T> submit(NodeID root, std::span<const T> inputs) {
+            if (!graph_->graph().alive(root)) {
+                throw std::runtime_error("node " + std::to_string(root.index()) + " is not in the graph");
+            }
+            if (inputs.size() < width_) {
+                throw std::runtime_error("expected " + std::to_string(width_) + " input values, got " +
+                                         std::to_string(inputs.size()));
+            }
+            std::promise<T> promise;
+            auto future = promise.get_future();
+            bool wake;
+            {
+                std::lock_guard lock(m_);
+                queue_.push_back(Request{root, Clock::now(), std::move(promise)});
+                queued_inputs_.insert(queued_inputs_.end(), inputs.begin(), inputs.begin() + width_);
+                // the dispatcher only cares about the first request (starts the clock) and a full batch
+                wake = queue_.size() == 1 || queue_.size() >= options_.max_batch;
+            }
+            if (wake) arrived_.notify_one();
+            return future;
+        }
+
+        const FrozenGraph<T>& graph() const noexcept { return *graph_; }
+        const ServiceOptions& options() const noexcept { return options_; }
+
+        Stats stats() const noexcept {
+            return {requests_.load(std::memory_order_relaxed), batches_.load(std::memory_order_relaxed)};
+        }
+
+    private:
+        struct Request {
+            NodeID root;
+            Clock::time_point arrival;
+            std::promise<T> promise;
+        };
+
+        void dispatch() {
+            std::unique_lock lock(m_);
+            while (true) {
+                arrived_.wait(lock, [this] { return stop_ || !queue_.empty(); });
+                if (queue_.empty()) return; // stopped and drained
+
+                if (options_.batching) {
+                    const auto deadline = queue_.front().arrival + options_.latency_budget;
+                    arrived_.wait_until(lock, deadline, [this] { return stop_ || queue_.size() >= options_.max_batch; });
+                }
+
+                // swap instead of copy, both sides keep their capacity from one batch to the next
+                batch_.clear();
+                batch_inputs_.clear();
+                std::swap(batch_, queue_);
+                std::swap(batch_inputs_, queued_inputs_);
+                lock.unlock();
+
+                const std::size_t step = options_.batching ? options_.max_batch : 1;
+                for (std::size_t first = 0; first < batch_.size(); first += step) {
+                    run(first, std::min(step, batch_.size() - first));
+                }
+
+                lock.lock();
+            }
+        }
+
+        // requests [first, first + n) of batch_
+        void run(std::size_t first, std::size_t n) {
+            const auto& G = *graph_;
+            batches_.fetch_add(1, std::memory_order_relaxed);
+            requests_.fetch_add(n, std::memory_order_relaxed);
+
+            if (n == 1) {
+                single(first);
+                return;
+            }
+
+            auto frame = Scratch<T>::acquire(G.size() * n);
+            auto pointers = Scratch<T*>::acquire(G.size());
+            bind_columns(frame.values(), n, pointers.values());
+            auto columns = pointers.values();
+
+            for (std::size_t s = 0; s < width_; ++s) {
+                T* column = columns[G.inputs()[s].index()];
+                for (std::size_t r = 0; r < n; ++r) column[r] = batch_inputs_[(first + r) * width_ + s];
+            }
+            try {
+                evaluate_block(G.graph(), G.ops(), columns, n);
+            } catch (...) {
+                // one bad row shouldn't fail its neighbours: redo them one at a time so only
+                // the culprit sees the exception
+                for (std::size_t r = 0; r < n; ++r) single(first + r);
+                return;
+            }
+            for (std::size_t r = 0; r < n; ++r) {
+                auto& request = batch_[first + r];
+                request.promise.set_value(columns[request.root.index()][r]);
+            }
+        }
+
+        void single(std::size_t i) {
+            auto& request = batch_[i];
+            try {
+                request.promise.set_value(
+                    graph_->evaluate(request.root, std::span<const T>(batch_inputs_.data() + i * width_, width_)));
+            } catch (...) {
+                request.promise.set_exception(std::current_exception());
+            }
+        }
+
+        std::shared_ptr<const FrozenGraph<T>> graph_;
+        ServiceOptions options_;
+        std::size_t width_;
+
+        std::mutex m_;
+        std::condition_variable arrived_;
+        bool stop_ = false;
+        std::vector<Request> queue_;   // guarded by m_
+        std::vector<T> queued_inputs_; // width_ values per queued request, guarded by m_
+
+        std::vector<Request> batch_;   // dispatcher only
+        std::vector<T> batch_inputs_;
+
+        std::atomic<std::size_t> requests_{0}, batches_{0};
+        std::thread dispatcher_;
+    };
+
+} // namespace cg::eval
@@ -0,0 +1,176 @@
+#pragma once
+#include "../frozen_graph.hpp"
+#include "../io/columnar_file.hpp"
+#include "batch.hpp"
+#include "scratch.hpp"
+
+#include <algorithm>
+#include <array>
+#include <condition_variable>
+#include <exception>
+#include <filesystem>
+#include <mutex>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace cg::eval {
+
+    struct StreamOptions {
+        std::size_t block_rows = 1 << 16; // rows staged per block, two blocks are in flight at a time
+        std::size_t cache_bytes = default_cache_bytes;
+    };
+
+    struct StreamStats {
+        std::size_t rows = 0;
+        std::size_t blocks = 0;
+    };
+
+    // evaluates `roots` for every row of a mapped columnar file and writes one output column per root
+    // (named after output_names) into a freshly created columnar file. input columns are matched to the
+    // graph's input nodes by name, extra columns are ignored.
+    //
+    // memory stays bounded regardless of the file size: rows move through two staging blocks, a loader
+    // thread fills block k + 1 (faulting its pages in) while block k is being evaluated, and pages
+    // that have been consumed or written are dropped from both mappings as the stream moves on
+    template<Numeric T>
+    StreamStats stream_evaluate(const FrozenGraph<T>& G, std::span<const NodeID> roots,
+                                const std::vector<std::string>& output_names,
+                                const std::string& input_path, const std::string& output_path,
+                                StreamOptions options = {}) {
+        if (output_names.size() != roots.size()) {
+            throw std::runtime_error("every root needs an output column name");
+        }
+        G.check_roots(roots);
+
+        // everything that can fail is checked before the output gets created (and truncated)
+        const auto in = io::ColumnarFile<T>::open(input_path);
+        const std::size_t slots = G.inputs().size();
+        std::vector<std::size_t> column_of(slots);
+        for (std::size_t s = 0; s < slots; ++s) {
+            column_of[s] = in.column_index(G.input_name(s));
+        }
+        // truncating the mapped input would fault on its next page
+        std::error_code ec;
+        if (std::filesystem::equivalent(input_path, output_path, ec)) {
+            throw std::runtime_error("output " + output_path + " is the input file");
+        }
+
+        auto out = io::ColumnarFile<T>::create(output_path, in.rows(), output_names);
+
+        const std::size_t rows = in.rows();
+        const std::size_t B = std::max<std::size_t>(options.block_rows, 1);
+        const std::size_t blocks = (rows + B - 1) / B;
+        const std::size_t chunk = block_rows<T>(G.size(), options.cache_bytes);
+
+        // staging[k % 2] holds block k's inputs, slot after slot
+        std::array<std::vector<T>, 2> staging;
+        staging[0].resize(slots * B);
+        staging[1].resize(slots * B);
+
+        // drops the pages of [from, to) once a block is done with them. only this block's range, starting
+        // at the page it shares with the previous block, which only now is consumed entirely
+        const std::size_t page = io::page_size();
+        auto evict = [page](const io::MappedFile& file, std::size_t from, std::size_t to) {
+            const std::size_t begin = from / page * page;
+            file.evict(begin, to - begin);
+        };
+
+        auto load = [&](std::size_t block, std::vector<T>& dst) {
+            const std::size_t first = block * B;
+            const std::size_t n = std::min(B, rows - first);
+            for (std::size_t s = 0; s < slots; ++s) {
+                const std::size_t col = column_of[s];
+                std::copy_n(in.column(col).data() + first, n, dst.data() + s * B);
+                evict(in.file(), in.offset(col, first), in.offset(col, first + n));
+                in.file().prefetch(in.offset(col, first + n), std::min(B, rows - first - n) * sizeof(T));
+            }
+        };
+
+        auto compute = [&](std::size_t block, const std::vector<T>& src) {
+            const std::size_t first = block * B;
+            const std::size_t n = std::min(B, rows - first);
+
+            auto frame = Scratch<T>::acquire(G.size() * chunk);
+            auto pointers = Scratch<T*>::acquire(G.size());
+            bind_columns(frame.values(), chunk, pointers.values());
+            auto columns = pointers.values();
+
+            for (std::size_t sub = 0; sub < n; sub += chunk) {
+                const std::size_t m = std::min(chunk, n - sub);
+                // inputs are read straight out of the staging block
+                for (std::size_t s = 0; s < slots; ++s) {
+                    columns[G.inputs()[s].index()] = const_cast<T*>(src.data() + s * B + sub);
+                }
+                evaluate_block(G.graph(), G.ops(), columns, m);
+                for (std::size_t i = 0; i < roots.size(); ++i) {
+                    std::copy_n(columns[roots[i].index()], m, out.column(i).data() + first + sub);
+                }
+            }
+
+            for (std::size_t i = 0; i < roots.size(); ++i) {
+                out.file().flush(out.offset(i, first), n * sizeof(T));
+                evict(out.file(), out.offset(i, first), out.offset(i, first + n));
+            }
+        };
+
+        if (blocks == 0) return StreamStats{rows, blocks};
+        load(0, staging[0]);
+
+        // one loader thread for the whole stream. block k + 1 goes into the buffer block k - 1 used,
+        // so the loader waits for that one to be computed and the main thread for its block to be loaded
+        std::mutex m;
+        std::condition_variable cv;
+        std::size_t loaded = 1, computed = 0; // blocks [0, loaded) are staged, [0, computed) written
+        bool stop = false;
+        std::exception_ptr failed;
+
+        std::thread loader([&] {
+            for (std::size_t k = 1; k < blocks; ++k) {
+                {
+                    std::unique_lock lock(m);
+                    cv.wait(lock, [&] { return stop || computed + 1 >= k; });
+                    if (stop) return;
+                }
+                try {
+                    load(k, staging[k % 2]);
+                } catch (...) {
+                    std::lock_guard lock(m);
+                    failed = std::current_exception();
+                    cv.notify_all();
+                    return;
+                }
+                std::lock_guard lock(m);
+                loaded = k + 1;
+                cv.notify_all();
+            }
+        });
+
+        try {
+            for (std::size_t k = 0; k < blocks; ++k) {
+                {
+                    std::unique_lock lock(m);
+                    cv.wait(lock, [&] { return failed || loaded > k; });
+                    if (failed) std::rethrow_exception(failed);
+                }
+                compute(k, staging[k % 2]);
+                std::lock_guard lock(m);
+                computed = k + 1;
+                cv.notify_all();
+            }
+        } catch (...) {
+            {
+                std::lock_guard lock(m);
+                stop = true;
+            }
+            cv.notify_all();
+            loader.join();
+            throw;
+        }
+        loader.join();
+
+        return StreamStats{rows, blocks};
+    }
+
+} // namespace cg::eval
@@ -0,0 +1,120 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace cg::eval {
+
+    // a fixed set of worker threads for fork-join loops. workers live as long as the pool,
+    // so whatever they keep thread_local (scratch buffers) survives from one loop to the next
+    class ThreadPool {
+    public:
+        // the calling thread takes part in every loop, so `threads` counts it too
+        explicit ThreadPool(std::size_t threads = std::thread::hardware_concurrency()) {
+            threads = std::max<std::size_t>(threads, 1);
+            workers_.reserve(threads - 1);
+            for (std::size_t i = 1; i < threads; ++i) {
+                workers_.emplace_back([this] { work(); });
+            }
+        }
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        ~ThreadPool() {
+            {
+                std::lock_guard lock(m_);
+                stop_ = true;
+            }
+            wake_.notify_all();
+            for (auto& w : workers_) w.join();
+        }
+
+        std::size_t size() const noexcept { return workers_.size() + 1; }
+
+        // runs fn(task) for every task in [0, tasks) and returns once all of them finished.
+        // the first exception thrown by a task is rethrown here, the remaining tasks are skipped
+        void parallel_for(std::size_t tasks, const std::function<void(std::size_t)>& fn) {
+            if (tasks == 0) return;
+
+            std::lock_guard serial(submit_); // one loop at a time
+            {
+                std::lock_guard lock(m_);
+                job_ = &fn;
+                tasks_ = tasks;
+                next_.store(0);
+                pending_ = workers_.size();
+                error_ = nullptr;
+                ++generation_;
+            }
+            wake_.notify_all();
+
+            drain();
+
+            std::unique_lock lock(m_);
+            done_.wait(lock, [this] { return pending_ == 0; });
+            job_ = nullptr;
+            if (error_) std::rethrow_exception(error_);
+        }
+
+    private:
+        void work() {
+            std::size_t seen = 0;
+            while (true) {
+                {
+                    std::unique_lock lock(m_);
+                    wake_.wait(lock, [&] { return stop_ || generation_ != seen; });
+                    if (stop_) return;
+                    seen = generation_;
+                }
+                drain();
+                {
+                    std::lock_guard lock(m_);
+                    --pending_;
+                }
+                done_.notify_one();
+            }
+        }
+
+        void drain() {
+            for (std::size_t t = next_.fetch_add(1); t < tasks_; t = next_.fetch_add(1)) {
+                try {
+                    (*job_)(t);
+                } catch (...) {
+                    std::lock_guard lock(m_);
+                    if (!error_) error_ = std::current_exception();
+                    next_.store(tasks_);
+                }
+            }
+        }
+
+        std::vector<std::thread> workers_;
+        std::mutex submit_;
+        std::mutex m_;
+        std::condition_variable wake_;
+        std::condition_variable done_;
+
+        const std::function<void(std::size_t)>* job_ = nullptr;
+        std::size_t tasks_ = 0;
+        std::atomic<std::size_t> next_{0};
+        std::size_t pending_ = 0;
+        std::size_t generation_ = 0;
+        std::exception_ptr error_;
+        bool stop_ = false;
+    };
+
+    // one pool per process with a thread per core, built on first use. the overloads that don't
+    // take a pool run on it, so their workers (and scratch) outlive the call as well.
+    // loops on it run one at a time, don't start one from inside a task
+    inline ThreadPool& default_pool() {
+        static ThreadPool pool;
+        return pool;
+    }
+
+} // namespace cg::eval
@@ -0,0 +1,376 @@
+#pragma once
+#include "../frozen_graph.hpp"
+#include "batch.hpp"
+#include "bulk.hpp"
+#include "scratch.hpp"
+#include "thread_pool.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <limits>
+#include <span>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+namespace cg::eval {
+
+    struct CacheSizes {
+        std::size_t l1d = 32 * 1024;
+        std::size_t l2 = 256 * 1024;
+        std::size_t l3 = 8 * 1024 * 1024;
+    };
+
+    namespace detail {
+
+        // "48K", "2048K", "8M" as found in sysfs
+        inline std::size_t parse_cache_size(const std::string& text) {
+            std::size_t value = 0, i = 0;
+            while (i < text.size() && text[i] >= '0' && text[i] <= '9') value = value * 10 + (text[i++] - '0');
+            if (i < text.size() && (text[i] == 'K' || text[i] == 'k')) value *= 1024;
+            if (i < text.size() && (text[i] == 'M' || text[i] == 'm')) value *= 1024 * 1024;
+            return value;
+        }
+
+        inline CacheSizes detect_cache_sizes() {
+            CacheSizes c;
+            auto known = [](long v) { return v > 0 ? static_cast<std::size_t>(v) : std::size_t{0}; };
+            std::size_t found[3] = {};
+#ifdef _SC_LEVEL1_DCACHE_SIZE
+            found[0] = known(::sysconf(_SC_LEVEL1_DCACHE_SIZE));
+            found[1] = known(::sysconf(_SC_LEVEL2_CACHE_SIZE));
+            found[2] = known(::sysconf(_SC_LEVEL3_CACHE_SIZE));
+#endif
+            // glibc's answers can be missing (or zero) in containers and on arm, sysfs usually isn't
+            for (int index = 0; index < 8; ++index) {
+                const std::string dir = "/sys/devices/system/cpu/cpu0/cache/index" + std::to_string(index) + "/";
+                std::ifstream level_file(dir + "level"), type_file(dir + "type"), size_file(dir + "size");
+                int level = 0;
+                std::string type, size;
+                if (!(level_file >> level) || !(type_file >> type) || !(size_file >> size)) continue;
+                if (type == "Instruction" || level < 1 || level > 3) continue;
+                if (!found[level - 1]) found[level - 1] = parse_cache_size(size);
+            }
+            if (found[0]) c.l1d = found[0];
+            if (found[1]) c.l2 = found[1];
+            if (found[2]) c.l3 = found[2];
+            return c;
+        }
+
+    } // namespace detail
+
+    // measured once per process, the defaults stand in for anything the system won't say
+    inline const CacheSizes& cache_sizes() {
+        static const CacheSizes sizes = detail::detect_cache_sizes();
+        return sizes;
+    }
+
+    struct TileOptions {
+        std::size_t tile_rows = 0;   // rows per tile, 0 derives them from the cache sizes
+        std::size_t cache_bytes = 0; // what one partition's columns may take over a tile, 0 is half the l2
+        std::size_t block_rows = 0;  // rows sharing one set of boundary columns, 0 picks a multiple of tile_rows
+    };
+
+    // cache-blocked execution of a large frozen graph over many rows. node-at-a-time evaluation over
+    // a block writes every intermediate column and reads it back later; once the graph is big that
+    // round trip leaves the cache (or the block shrinks until per-node dispatch dominates).
+    // the plan cuts the execution order into partitions whose columns fit the cache over one tile of
+    // rows, and runs a block partition by partition, each over all of the block's tiles in turn.
+    // values used only inside their partition live in a tile-sized buffer that never leaves the
+    // cache; only values crossing a partition boundary (and the roots) get full block-length columns,
+    // whose slots are recycled once their last consumer's partition has run.
+    // `G` must outlive the plan, every root to be read back has to be passed in up front
+    template<Numeric T>
+    class TiledPlan {
+    public:
+        static constexpr std::size_t npos = std::numeric_limits<std::size_t>::max();
+
+        struct Partition {
+            std::size_t first = 0, last = 0; // range of G.ops()
+            std::vector<std::pair<NodeID, std::size_t>> wide;  // touched nodes with a block column, and its slot
+            std::vector<std::pair<NodeID, std::size_t>> local; // nodes in the tile buffer, and their slot
+        };
+
+        TiledPlan(const FrozenGraph<T>& G, std::span<const NodeID> roots, TileOptions options = {})
+            : G_(&G), roots_(roots.begin(), roots.end()) {
+            G.check_roots(roots);
+            const auto& caches = cache_sizes();
+            const std::size_t budget = options.cache_bytes ? options.cache_bytes : caches.l2 / 2;
+            tile_ = options.tile_rows ? options.tile_rows : tile_for(budget);
+            const std::size_t cap = std::max<std::size_t>(budget / (tile_ * sizeof(T)), 2);
+
+            partition(cap);
+            assign_slots();
+
+            if (options.block_rows) {
+                block_ = (options.block_rows + tile_ - 1) / tile_ * tile_;
+            } else {
+                // enough tiles to amortize each partition's setup, as long as the boundary columns
+                // stay within a share of the l3
+                const std::size_t per_tile = std::max<std::size_t>(wide_, 1) * tile_ * sizeof(T);
+                block_ = tile_ * std::clamp<std::size_t>(caches.l3 / 4 / per_tile, 1, 16);
+            }
+        }
+
+        const FrozenGraph<T>& graph() const noexcept { return *G_; }
+        std::span<const NodeID> roots() const noexcept { return roots_; }
+        std::span<const Partition> partitions() const noexcept { return parts_; }
+        std::size_t tile_rows() const noexcept { return tile_; }
+        std::size_t block_rows() const noexcept { return block_; }
+
+        // block columns needed at once, and tile columns of the widest partition
+        std::size_t wide_slots() const noexcept { return wide_; }
+        std::size_t local_slots() const noexcept { return local_; }
+
+        // values per row that go through a block column: the inputs plus every node read outside
+        // its own partition. node-at-a-time evaluation does this for every node
+        std::size_t boundary_values() const noexcept { return boundary_; }
+
+        // rows [first, first + n) of `table` into out[0, n), n <= block_rows(). node-major scratch
+        // of the calling thread. throws when the rows or an input column aren't in the table
+        template<typename Table>
+        void evaluate_block(NodeID root, const Table& table, std::size_t first, std::size_t n, std::span<T> out) const {
+            if (std::find(roots_.begin(), roots_.end(), root) == roots_.end()) {
+                throw std::runtime_error("node " + std::to_string(root.index()) + " is not a root of this plan");
+            }
+            check_block(table, first, n, std::span<const std::span<T>>(&out, 1));
+            sweep(table, first, n, [&](const T* wide, std::size_t stride) {
+                std::copy_n(wide + slot_[root.index()] * stride, n, out.begin());
+            });
+        }
+
+        // same, for every root of the plan in one pass: outs[i] receives roots()[i]
+        template<typename Table>
+        void evaluate_block(const Table& table, std::size_t first, std::size_t n, std::span<const std::span<T>> outs) const {
+            if (outs.size() != roots_.size()) {
+                throw std::runtime_error("expected " + std::to_string(roots_.size()) + " outputs, got " +
+                                         std::to_string(outs.size()));
+            }
+            check_block(table, first, n, outs);
+            sweep(table, first, n, [&](const T* wide, std::size_t stride) {
+                for (std::size_t i = 0; i < roots_.size(); ++i) {
+                    std::copy_n(wide + slot_[roots_[i].index()] * stride, n, outs[i].begin());
+                }
+            });
+        }
+
+    private:
+        template<typename Table>
+        void check_block(const Table& table, std::size_t first, std::size_t n, std::span<const std::span<T>> outs) const {
+            // the boundary columns are block_rows() long
+            if (n > block_) {
+                throw std::runtime_error("block of " + std::to_string(n) + " rows, the plan takes at most " +
+                                         std::to_string(block_));
+            }
+            detail::check_table(*G_, table);
+            if (first > table.rows() || n > table.rows() - first) {
+                throw std::runtime_error("rows " + std::to_string(first) + " to " + std::to_string(first + n) +
+                                         " are past the end of a table of " + std::to_string(table.rows()));
+            }
+            for (const auto& out : outs) {
+                if (out.size() < n) {
+                    throw std::runtime_error("expected room for " + std::to_string(n) + " rows, got " +
+                                             std::to_string(out.size()));
+                }
+            }
+        }
+
+        // runs rows [first, first + n) through every partition, then emit(block columns, stride)
+        // reads the roots out before the scratch goes
+        template<typename Table, typename Emit>
+        void sweep(const Table& table, std::size_t first, std::size_t n, Emit&& emit) const {
+            const auto& G = *G_;
+            auto wide = Scratch<T>::acquire(wide_ * block_);
+            auto local = Scratch<T>::acquire(local_ * tile_);
+            auto pointers = Scratch<T*>::acquire(G.size());
+            T* wide_base = wide.values().data();
+            T* local_base = local.values().data();
+            auto columns = pointers.values();
+
+            for (std::size_t s = 0; s < G.inputs().size(); ++s) {
+                const NodeID input = G.inputs()[s];
+                detail::gather(table, s, first, std::span<T>(wide_base + slot_[input.index()] * block_, n));
+            }
+
+            const auto ops = G.ops();
+            for (const auto& part : parts_) {
+                for (auto [id, slot] : part.local) columns[id.index()] = local_base + slot * tile_;
+                for (std::size_t t = 0; t < n; t += tile_) {
+                    const std::size_t m = std::min(tile_, n - t);
+                    for (auto [id, slot] : part.wide) columns[id.index()] = wide_base + slot * block_ + t;
+                    for (std::size_t i = part.first; i < part.last; ++i) {
+                        G.node(ops[i]).evaluate_batch(columns, std::span<T>(columns[ops[i].index()], m));
+                    }
+                }
+            }
+            emit(static_cast<const T*>(wide_base), block_);
+        }
+
+        // as many rows as keep at least a few dozen nodes per partition, capped where longer
+        // tiles stop paying off
+        std::size_t tile_for(std::size_t budget) const {
+            const std::size_t min_nodes = std::min<std::size_t>(32, std::max<std::size_t>(G_->size(), 1));
+            const std::size_t rows = std::clamp<std::size_t>(budget / (min_nodes * sizeof(T)), 8, 256);
+            return rows / 8 * 8;
+        }
+
+        // greedy over the execution order: a partition grows until the nodes it writes or reads
+        // would no longer fit `cap` columns of a tile
+        void partition(std::size_t cap) {
+            const auto& G = *G_;
+            const auto ops = G.ops();
+            part_of_.assign(G.size(), npos);
+            std::vector<std::size_t> stamp(G.size(), npos);
+            std::size_t touched = 0;
+
+            Partition current;
+            for (std::size_t i = 0; i < ops.size(); ++i) {
+                const NodeID id = ops[i];
+                const std::size_t p = parts_.size();
+                std::size_t fresh = 1;
+                for (auto dep : G.node(id).inputs()) fresh += stamp[dep.index()] != p;
+                if (touched + fresh > cap && i > current.first) {
+                    current.last = i;
+                    parts_.push_back(std::move(current));
+                    current = Partition{};
+                    current.first = i;
+                    touched = 0;
+                }
+                const std::size_t q = parts_.size();
+                for (auto dep : G.node(id).inputs()) {
+                    if (stamp[dep.index()] != q) {
+                        stamp[dep.index()] = q;
+                        ++touched;
+                    }
+                }
+                stamp[id.index()] = q;
+                ++touched;
+                part_of_[id.index()] = q;
+            }
+            current.last = ops.size();
+            if (current.last > current.first) parts_.push_back(std::move(current));
+        }
+
+        // block column slots by liveness: a boundary value takes a slot in its partition and gives it
+        // back after the last partition reading it. inputs hold theirs from the start, roots forever
+        void assign_slots() {
+            const auto& G = *G_;
+            const auto& graph = G.graph();
+            constexpr std::size_t forever = npos;
+            slot_.assign(G.size(), npos);
+            std::vector<std::size_t> last_use(G.size(), npos);
+            std::vector<bool> wide(G.size(), false);
+
+            for (auto id : G.order()) {
+                const std::size_t own = part_of_[id.index()]; // npos for inputs
+                std::size_t last = 0;
+                bool crosses = own == npos;
+                for (auto user : graph.consumers(id)) {
+                    crosses = crosses || part_of_[user.index()] != own;
+                    last = std::max(last, part_of_[user.index()]);
+                }
+                if (std::find(roots_.begin(), roots_.end(), id) != roots_.end()) {
+                    crosses = true;
+                    last = forever;
+                }
+                wide[id.index()] = crosses;
+                last_use[id.index()] = last;
+            }
+
+            std::vector<std::size_t> free_slots;
+            auto take = [&](NodeID id) {
+                if (free_slots.empty()) {
+                    slot_[id.index()] = wide_++;
+                } else {
+                    slot_[id.index()] = free_slots.back();
+                    free_slots.pop_back();
+                }
+                ++boundary_;
+            };
+            // slots released after partition p
+            std::vector<std::vector<NodeID>> release(parts_.size());
+            auto schedule_release = [&](NodeID id) {
+                if (last_use[id.index()] != forever) release[last_use[id.index()]].push_back(id);
+            };
+
+            for (auto id : G.inputs()) {
+                take(id);
+                if (!graph.consumers(id).empty()) schedule_release(id);
+            }
+
+            const auto ops = G.ops();
+            for (std::size_t p = 0; p < parts_.size(); ++p) {
+                auto& part = parts_[p];
+                for (std::size_t i = part.first; i < part.last; ++i) {
+                    const NodeID id = ops[i];
+                    if (wide[id.index()]) {
+                        take(id);
+                        schedule_release(id);
+                        part.wide.emplace_back(id, slot_[id.index()]);
+                    } else {
+                        part.local.emplace_back(id, part.local.size());
+                    }
+                }
+                // boundary values read here, produced in an earlier partition or gathered inputs
+                for (std::size_t i = part.first; i < part.last; ++i) {
+                    for (auto dep : G.node(ops[i]).inputs()) {
+                        if (part_of_[dep.index()] == p) continue;
+                        const std::pair<NodeID, std::size_t> entry{dep, slot_[dep.index()]};
+                        if (std::find(part.wide.begin(), part.wide.end(), entry) == part.wide.end()) {
+                            part.wide.push_back(entry);
+                        }
+                    }
+                }
+                local_ = std::max(local_, part.local.size());
+                for (auto id : release[p]) free_slots.push_back(slot_[id.index()]);
+            }
+        }
+
+        const FrozenGraph<T>* G_;
+        std::vector<NodeID> roots_;
+        std::vector<Partition> parts_;
+        std::vector<std::size_t> part_of_; // partition of each op, npos for inputs
+        std::vector<std::size_t> slot_;    // block column of each boundary value while it's live
+        std::size_t tile_ = 8, block_ = 8;
+        std::size_t wide_ = 0, local_ = 0, boundary_ = 0;
+    };
+
+    // bulk_evaluate through a TiledPlan: blocks of plan.block_rows() rows are spread over the pool,
+    // each thread in its own scratch. `root` must be one of the plan's roots
+    template<Numeric T, typename Table>
+    void tiled_evaluate(ThreadPool& pool, const TiledPlan<T>& plan, NodeID root, const Table& table, std::span<T> out) {
+        detail::check(plan.graph(), table, out);
+        const std::size_t rows = table.rows();
+        const std::size_t block = plan.block_rows();
+        const std::size_t blocks = (rows + block - 1) / block;
+        pool.parallel_for(blocks, [&](std::size_t b) {
+            const std::size_t first = b * block;
+            const std::size_t n = std::min(block, rows - first);
+            plan.evaluate_block(root, table, first, n, out.subspan(first, n));
+        });
+    }
+
+    // every root of the plan in one pass over the graph: outs[i] receives plan.roots()[i]
+    template<Numeric T, typename Table>
+    void tiled_evaluate(ThreadPool& pool, const TiledPlan<T>& plan, const Table& table,
+                        std::span<const std::span<T>> outs) {
+        if (outs.size() != plan.roots().size()) {
+            throw std::runtime_error("expected " + std::to_string(plan.roots().size()) + " outputs, got " +
+                                     std::to_string(outs.size()));
+        }
+        for (const auto& out : outs) detail::check(plan.graph(), table, out);
+        const std::size_t rows = table.rows();
+        const std::size_t block = plan.block_rows();
+        const std::size_t blocks = (rows + block - 1) / block;
+        pool.parallel_for(blocks, [&](std::size_t b) {
+            const std::size_t first = b * block;
+            const std::size_t n = std::min(block, rows - first);
+            std::vector<std::span<T>> parts;
+            parts.reserve(outs.size());
+            for (const auto& out : outs) parts.push_back(out.subspan(first, n));
+            plan.evaluate_block(table, first, n, std::span<const std::span<T>>(parts));
+        });
+    }
+
+} // namespace cg::eval
@@ -4,6 +4,7 @@
 
 #include <cassert>
 #include <numbers>
+#include <type_traits>
 
 namespace cg {
 
@@ -116,54 +117,55 @@ namespace cg {
     }
 
     // --------- EXPRESSION <-> SCALAR OPERATORS ---------
+    // the scalar only has to convert to T, so x * 2.0 works in a Graph<Dual<Dual<double>>> too
 
     template<Numeric T>
-    Expression<T> operator+(Expression<T> a, T scalar) {
+    Expression<T> operator+(Expression<T> a, std::type_identity_t<T> scalar) {
         return a + constant(a.graph(), scalar);
     }
 
     template<Numeric T>
-    Expression<T> operator+(T scalar, Expression<T> a) {
+    Expression<T> operator+(std::type_identity_t<T> scalar, Expression<T> a) {
         return constant(a.graph(), scalar) + a;
     }
 
     template<Numeric T>
-    Expression<T> operator-(Expression<T> a, T scalar) {
+    Expression<T> operator-(Expression<T> a, std::type_identity_t<T> scalar) {
         return a - constant(a.graph(), scalar);
     }
 
     template<Numeric T>
-    Expression<T> operator-(T scalar, Expression<T> a) {
+    Expression<T> operator-(std::type_identity_t<T> scalar, Expression<T> a) {
         return constant(a.graph(), scalar) - a;
     }
 
     template<Numeric T>
-    Expression<T> operator*(Expression<T> a, T scalar) {
+    Expression<T> operator*(Expression<T> a, std::type_identity_t<T> scalar) {
         return a * constant(a.graph(), scalar);
     }
 
     template<Numeric T>
-    Expression<T> operator*(T scalar, Expression<T> a) {
+    Expression<T> operator*(std::type_identity_t<T> scalar, Expression<T> a) {
         return constant(a.graph(), scalar) * a;
     }
 
     template<Numeric T>
-    Expression<T> operator/(Expression<T> a, T scalar) {
+    Expression<T> operator/(Expression<T> a, std::type_identity_t<T> scalar) {
         return a / constant(a.graph(), scalar);
     }
 
     template<Numeric T>
-    Expression<T> operator/(T scalar, Expression<T> a) {
+    Expression<T> operator/(std::type_identity_t<T> scalar, Expression<T> a) {
         return constant(a.graph(), scalar) / a;
     }
 
     template<Numeric T>
-    Expression<T> pow(Expression<T> base, T exponent) {
+    Expression<T> pow(Expression<T> base, std::type_identity_t<T> exponent) {
         return binary<T>(base, constant(base.graph(), exponent), ops::Pow{});
     }
 
     template<Numeric T>
-    Expression<T> pow(T base, Expression<T> exponent) {
+    Expression<T> pow(std::type_identity_t<T> base, Expression<T> exponent) {
         return binary<T>(constant(exponent.graph(), base), exponent, ops::Pow{});
     }
 
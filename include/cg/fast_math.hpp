@@ -0,0 +1,300 @@
+#pragma once
+#include <bit>
+#include <cmath>
+#include <concepts>
+#include <cstdint>
+#include <limits>
+#include <span>
+
+namespace cg::fast {
+
+    // polynomial replacements for the libm calls behind ops::Sin, Cos, Exp, Log and Pow.
+    // the cores are branch free (bit masks instead of selects) so gcc vectorizes the span variants
+    // even for plain sse2. maximum relative errors over their domains, measured with
+    // bench/bench_fast_math.cpp plus margin:
+    //
+    //   exp   x in [-708, 709]          1e-11
+    //   log   x normal and positive     2e-12
+    //   sin   |x| < 2^20                absolute 1e-14, no relative bound: it blows up at the zeros
+    //   cos   |x| < 2^20                absolute 1e-14, same
+    //   pow   a > 0                     2e-12 * (1 + |b log a|), so 2e-9 whenever the result is normal
+    //
+    // outside those domains the scalar functions fall back to libm, the span variants patch
+    // the few affected elements up in a second pass
+
+    namespace detail {
+
+        inline constexpr double ln2_hi = 6.93147180369123816490e-01;
+        inline constexpr double ln2_lo = 1.90821492927058770002e-10;
+        inline constexpr double log2e = 1.44269504088896338700e+00;
+
+        // pi/2 split into three parts for cody-waite reduction
+        inline constexpr double pio2_1 = 1.57079632673412561417e+00;
+        inline constexpr double pio2_2 = 6.07710050650619224932e-11;
+        inline constexpr double pio2_3 = 2.02226624879595063154e-21;
+        inline constexpr double two_over_pi = 6.36619772367581382433e-01;
+
+        inline constexpr double trig_limit = 1048576.0; // 2^20
+
+        // adding 1.5 * 2^52 rounds to the nearest integer and leaves it in the low mantissa bits,
+        // unlike nearbyint and int conversions this maps onto plain sse2/avx2 lanes
+        inline constexpr double two52 = 4503599627370496.0;
+        inline constexpr double round_magic = 1.5 * two52;
+
+        // x in [-708, 709], callers patch up everything outside. gcc won't vectorize a clamp here
+        inline double exp_core(double x) noexcept {
+            const double t = x * log2e + round_magic;
+            const double k = t - round_magic;
+            const double r = (x - k * ln2_hi) - k * ln2_lo; // |r| <= ln2 / 2
+            // taylor to r^9, horner form
+            double p = 1.0 / 362880.0;
+            p = p * r + 1.0 / 40320.0;
+            p = p * r + 1.0 / 5040.0;
+            p = p * r + 1.0 / 720.0;
+            p = p * r + 1.0 / 120.0;
+            p = p * r + 1.0 / 24.0;
+            p = p * r + 1.0 / 6.0;
+            p = p * r + 0.5;
+            p = p * r + 1.0;
+            p = p * r + 1.0;
+            // 2^k straight into the exponent field, k sits in the low bits of t
+            const auto scale = (std::bit_cast<std::uint64_t>(t) + 1023) << 52;
+            return p * std::bit_cast<double>(scale);
+        }
+
+        // x = m 2^e with m in [sqrt(1/2), sqrt(2)), log m = 2 atanh(s) with s = (m - 1) / (m + 1).
+        // subtracting the bits of sqrt(1/2) (biased so it can't wrap for normal x) carries into the
+        // exponent exactly when m >= sqrt(2), so the split needs no compare
+        inline double log_core(double x) noexcept {
+            constexpr std::uint64_t sqrt_half = 0x3fe6a09e667f3bcdULL;
+            constexpr std::uint64_t bias = 1022ULL << 52;
+            const auto bits = std::bit_cast<std::uint64_t>(x);
+            const std::uint64_t k = (bits - sqrt_half + bias) >> 52; // e + 1022
+            const double m = std::bit_cast<double>(bits - (k << 52) + bias);
+            // k to double through the mantissa of 2^52, again avoiding int conversions
+            const double e = std::bit_cast<double>(0x4330000000000000ULL | k) - two52 - 1022.0;
+
+            const double s = (m - 1.0) / (m + 1.0); // |s| < 0.1716
+            const double z = s * s;
+            double p = 1.0 / 13.0;
+            p = p * z + 1.0 / 11.0;
+            p = p * z + 1.0 / 9.0;
+            p = p * z + 1.0 / 7.0;
+            p = p * z + 1.0 / 5.0;
+            p = p * z + 1.0 / 3.0;
+            p = p * z + 1.0;
+            return e * ln2_hi + (2.0 * s * p + e * ln2_lo);
+        }
+
+        // sin and cos of the reduced argument |r| <= pi/4
+        inline double sin_poly(double r) noexcept {
+            const double z = r * r;
+            double p = -1.0 / 1307674368000.0;
+            p = p * z + 1.0 / 6227020800.0;
+            p = p * z - 1.0 / 39916800.0;
+            p = p * z + 1.0 / 362880.0;
+            p = p * z - 1.0 / 5040.0;
+            p = p * z + 1.0 / 120.0;
+            p = p * z - 1.0 / 6.0;
+            return r + r * z * p;
+        }
+
+        inline double cos_poly(double r) noexcept {
+            const double z = r * r;
+            double p = 1.0 / 87178291200.0;
+            p = p * z - 1.0 / 479001600.0;
+            p = p * z + 1.0 / 3628800.0;
+            p = p * z - 1.0 / 40320.0;
+            p = p * z + 1.0 / 720.0;
+            p = p * z - 1.0 / 24.0;
+            p = p * z + 0.5;
+            return 1.0 - z * p;
+        }
+
+        // x = k pi/2 + r, returns r and the quadrant k mod 4
+        inline double reduce(double x, std::uint64_t& quadrant) noexcept {
+            const double t = x * two_over_pi + round_magic;
+            const double k = t - round_magic;
+            quadrant = std::bit_cast<std::uint64_t>(t) & 3;
+            return ((x - k * pio2_1) - k * pio2_2) - k * pio2_3;
+        }
+
+        // quadrant selects as bit masks, sse2 has no 64 bit compares to if-convert a ternary with
+        inline double pick(std::uint64_t quadrant, double s, double c, std::uint64_t negate) noexcept {
+            const auto sb = std::bit_cast<std::uint64_t>(s);
+            const auto cb = std::bit_cast<std::uint64_t>(c);
+            const std::uint64_t odd = 0 - (quadrant & 1);
+            return std::bit_cast<double>((sb ^ ((sb ^ cb) & odd)) ^ (negate << 62));
+        }
+
+        inline double sin_core(double x) noexcept {
+            std::uint64_t q;
+            const double r = reduce(x, q);
+            return pick(q, sin_poly(r), cos_poly(r), q & 2);
+        }
+
+        // cos(r + q pi/2) = sin(r + (q + 1) pi/2)
+        inline double cos_core(double x) noexcept {
+            std::uint64_t q;
+            const double r = reduce(x, q);
+            return pick(q + 1, sin_poly(r), cos_poly(r), (q + 1) & 2);
+        }
+
+        inline bool exp_in_domain(double x) noexcept { return x >= -708.0 && x <= 709.0; }
+        inline bool log_in_domain(double x) noexcept {
+            return x >= std::numeric_limits<double>::min() && x <= std::numeric_limits<double>::max();
+        }
+        inline bool trig_in_domain(double x) noexcept { return std::abs(x) < trig_limit; }
+
+    } // namespace detail
+
+    inline double exp(double x) noexcept {
+        return detail::exp_in_domain(x) ? detail::exp_core(x) : std::exp(x);
+    }
+
+    inline double log(double x) noexcept {
+        return detail::log_in_domain(x) ? detail::log_core(x) : std::log(x);
+    }
+
+    inline double sin(double x) noexcept {
+        return detail::trig_in_domain(x) ? detail::sin_core(x) : std::sin(x);
+    }
+
+    inline double cos(double x) noexcept {
+        return detail::trig_in_domain(x) ? detail::cos_core(x) : std::cos(x);
+    }
+
+    inline double pow(double a, double b) noexcept {
+        if (!(a > 0.0) || !detail::log_in_domain(a)) return std::pow(a, b);
+        return fast::exp(b * detail::log_core(a));
+    }
+
+    // span variants: a branch free sweep, then libm for whatever fell outside the domain
+
+    namespace detail {
+        template<typename Core, typename Domain, typename Libm>
+        void sweep(std::span<const double> in, std::span<double> out, Core core, Domain domain, Libm libm) {
+            const std::size_t n = in.size();
+            for (std::size_t i = 0; i < n; ++i) out[i] = core(in[i]);
+            for (std::size_t i = 0; i < n; ++i) {
+                if (!domain(in[i])) out[i] = libm(in[i]);
+            }
+        }
+    } // namespace detail
+
+    inline void exp(std::span<const double> in, std::span<double> out) noexcept {
+        detail::sweep(in, out, detail::exp_core, detail::exp_in_domain, [](double x) { return std::exp(x); });
+    }
+
+    inline void log(std::span<const double> in, std::span<double> out) noexcept {
+        detail::sweep(in, out, detail::log_core, detail::log_in_domain, [](double x) { return std::log(x); });
+    }
+
+    inline void sin(std::span<const double> in, std::span<double> out) noexcept {
+        detail::sweep(in, out, detail::sin_core, detail::trig_in_domain, [](double x) { return std::sin(x); });
+    }
+
+    inline void cos(std::span<const double> in, std::span<double> out) noexcept {
+        detail::sweep(in, out, detail::cos_core, detail::trig_in_domain, [](double x) { return std::cos(x); });
+    }
+
+    inline void pow(std::span<const double> a, std::span<const double> b, std::span<double> out) noexcept {
+        const std::size_t n = a.size();
+        for (std::size_t i = 0; i < n; ++i) {
+            out[i] = detail::exp_core(b[i] * detail::log_core(a[i]));
+        }
+        // |log a| < (|e| + 1) ln 2 for a = m 2^e, a cheap bound that keeps b log a inside exp's domain
+        for (std::size_t i = 0; i < n; ++i) {
+            const auto e = static_cast<double>(static_cast<int>((std::bit_cast<std::uint64_t>(a[i]) >> 52) & 0x7ff) - 1023);
+            const bool safe = a[i] > 0.0 && detail::log_in_domain(a[i]) &&
+                              std::abs(b[i]) * (std::abs(e) + 1.0) * detail::ln2_hi < 708.0;
+            if (!safe) out[i] = fast::pow(a[i], b[i]);
+        }
+    }
+
+    // the documented bounds above as numbers, opt::FastMath only swaps an op in when one of its
+    // bounds fits the matching tolerance. infinity means no such guarantee
+    enum class Function { sin, cos, exp, log, pow };
+
+    inline constexpr double max_relative_error(Function f) noexcept {
+        switch (f) {
+            case Function::exp: return 1e-11;
+            case Function::log: return 2e-12;
+            case Function::pow: return 2e-9;
+            case Function::sin:
+            case Function::cos: return std::numeric_limits<double>::infinity();
+        }
+        return 0.0;
+    }
+
+    inline constexpr double max_absolute_error(Function f) noexcept {
+        switch (f) {
+            case Function::sin:
+            case Function::cos: return 1e-14;
+            default: return std::numeric_limits<double>::infinity();
+        }
+    }
+
+    // sin and cos only ever pass on the absolute tolerance
+    inline constexpr bool within(Function f, double relative, double absolute) noexcept {
+        return max_relative_error(f) <= relative || max_absolute_error(f) <= absolute;
+    }
+
+} // namespace cg::fast
+
+namespace cg::ops::fast {
+
+    // drop-in functors for floating point graphs, same symbols as their exact counterparts.
+    // float goes through the double kernels, which is well inside float precision. the batch
+    // members are picked up by UnaryNode/BinaryNode::evaluate_batch on Graph<double>
+
+    struct Sin {
+        static constexpr auto symbol = "sin";
+
+        template<std::floating_point T>
+        T operator()(T x) const { return static_cast<T>(cg::fast::sin(static_cast<double>(x))); }
+
+        void batch(std::span<const double> x, std::span<double> out) const { cg::fast::sin(x, out); }
+    };
+
+    struct Cos {
+        static constexpr auto symbol = "cos";
+
+        template<std::floating_point T>
+        T operator()(T x) const { return static_cast<T>(cg::fast::cos(static_cast<double>(x))); }
+
+        void batch(std::span<const double> x, std::span<double> out) const { cg::fast::cos(x, out); }
+    };
+
+    struct Exp {
+        static constexpr auto symbol = "exp";
+
+        template<std::floating_point T>
+        T operator()(T x) const { return static_cast<T>(cg::fast::exp(static_cast<double>(x))); }
+
+        void batch(std::span<const double> x, std::span<double> out) const { cg::fast::exp(x, out); }
+    };
+
+    struct Log {
+        static constexpr auto symbol = "log";
+
+        template<std::floating_point T>
+        T operator()(T x) const { return static_cast<T>(cg::fast::log(static_cast<double>(x))); }
+
+        void batch(std::span<const double> x, std::span<double> out) const { cg::fast::log(x, out); }
+    };
+
+    struct Pow {
+        static constexpr auto symbol = "pow";
+
+        template<std::floating_point T>
+        T operator()(T base, T exponent) const {
+            return static_cast<T>(cg::fast::pow(static_cast<double>(base), static_cast<double>(exponent)));
+        }
+
+        void batch(std::span<const double> base, std::span<const double> exponent, std::span<double> out) const {
+            cg::fast::pow(base, exponent, out);
+        }
+    };
+
+} // namespace cg::ops::fast
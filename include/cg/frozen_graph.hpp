@@ -0,0 +1,158 @@
+#pragma once
+#include "graph.hpp"
+#include "eval/policies.hpp"
+#include "eval/scratch.hpp"
+
+#include <limits>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace cg {
+
+    // an immutable snapshot of a graph that's safe to share between threads.
+    // the execution order and input slots are computed once at freeze time,
+    // evaluation only touches the calling thread's scratch buffer
+    template<Numeric T>
+    class FrozenGraph {
+    public:
+        static constexpr std::size_t npos = std::numeric_limits<std::size_t>::max();
+
+        explicit FrozenGraph(Graph<T> G) : graph_(std::move(G)) {
+            order_ = graph_.topological_sort();
+            ops_.reserve(order_.size());
+
+            for (auto id : order_) {
+                const auto& node = graph_.node(id);
+                if (node.kind() == "input") {
+                    inputs_.push_back(id);
+                } else {
+                    ops_.push_back(id);
+                }
+            }
+        }
+
+        std::size_t size() const noexcept { return graph_.size(); }
+
+        // per evaluating thread: its scratch frame plus the schedule computed at freeze time.
+        // graph().memory() has the graph itself
+        eval::EvaluationMemory memory() const noexcept {
+            return {graph_.size() * sizeof(T),
+                    (order_.capacity() + ops_.capacity() + inputs_.capacity()) * sizeof(NodeID)};
+        }
+        const Node<T>& node(NodeID id) const { return graph_.node(id); }
+        const Graph<T>& graph() const noexcept { return graph_; }
+
+        // full execution order and the part of it that isn't an input
+        std::span<const NodeID> order() const noexcept { return order_; }
+        std::span<const NodeID> ops() const noexcept { return ops_; }
+
+        // input nodes in slot order, positional evaluation expects values in this order
+        std::span<const NodeID> inputs() const noexcept { return inputs_; }
+
+        const std::string& input_name(std::size_t slot) const {
+            return static_cast<const InputNode<T>&>(graph_.node(inputs_.at(slot))).name();
+        }
+
+        std::size_t slot(std::string_view name) const noexcept {
+            for (std::size_t s = 0; s < inputs_.size(); ++s) {
+                if (input_name(s) == name) return s;
+            }
+            return npos;
+        }
+
+        // positional inputs, see inputs() for the slot order
+        T evaluate(NodeID root, std::span<const T> inputs) const {
+            T out{};
+            evaluate(std::span<const NodeID>(&root, 1), inputs, std::span<T>(&out, 1));
+            return out;
+        }
+
+        // writes into `out`, which keeps its storage: with preallocated slots a steady stream of
+        // tensor evaluations doesn't allocate at all
+        void evaluate(NodeID root, std::span<const T> inputs, T& out) const {
+            evaluate(std::span<const NodeID>(&root, 1), inputs, std::span<T>(&out, 1));
+        }
+
+        T evaluate(NodeID root, const Context<T>& ctx) const {
+            T out{};
+            evaluate(std::span<const NodeID>(&root, 1), ctx, std::span<T>(&out, 1));
+            return out;
+        }
+
+        // one sweep for several outputs, out[i] receives the value of roots[i]
+        void evaluate(std::span<const NodeID> roots, std::span<const T> inputs, std::span<T> out) const {
+            check(roots, out);
+            if (inputs.size() < inputs_.size()) {
+                throw std::runtime_error("expected " + std::to_string(inputs_.size()) + " input values, got " +
+                                         std::to_string(inputs.size()));
+            }
+
+            auto frame = eval::Scratch<T>::acquire(graph_.size());
+            auto values = frame.values();
+
+            for (std::size_t s = 0; s < inputs_.size(); ++s) {
+                values[inputs_[s].index()] = inputs[s];
+            }
+            run(values, roots, out);
+        }
+
+        void evaluate(std::span<const NodeID> roots, const Context<T>& ctx, std::span<T> out) const {
+            check(roots, out);
+            auto frame = eval::Scratch<T>::acquire(graph_.size());
+            auto values = frame.values();
+
+            for (std::size_t s = 0; s < inputs_.size(); ++s) {
+                const auto& name = input_name(s);
+                auto it = ctx.find(name);
+                if (it == ctx.end()) {
+                    throw std::runtime_error("missing value for input variable: " + name);
+                }
+                values[inputs_[s].index()] = it->second;
+            }
+            run(values, roots, out);
+        }
+
+        // throws unless every root is a live node of the graph, the evaluators built on top of a
+        // frozen graph call this before they index their buffers with a root
+        void check_roots(std::span<const NodeID> roots) const {
+            for (auto root : roots) {
+                if (!graph_.alive(root)) {
+                    throw std::runtime_error("node " + std::to_string(root.index()) + " is not in the graph");
+                }
+            }
+        }
+
+    private:
+        void check(std::span<const NodeID> roots, std::span<T> out) const {
+            if (out.size() < roots.size()) {
+                throw std::runtime_error("expected room for " + std::to_string(roots.size()) + " outputs, got " +
+                                         std::to_string(out.size()));
+            }
+            check_roots(roots);
+        }
+
+        void run(std::span<T> values, std::span<const NodeID> roots, std::span<T> out) const {
+            for (auto id : ops_) {
+                graph_.node(id).evaluate_into(values, values[id.index()]);
+            }
+            for (std::size_t i = 0; i < roots.size(); ++i) {
+                out[i] = values[roots[i].index()];
+            }
+        }
+
+        Graph<T> graph_;
+        std::vector<NodeID> order_;
+        std::vector<NodeID> ops_;
+        std::vector<NodeID> inputs_;
+    };
+
+    // hands the graph over to an immutable, shareable snapshot
+    template<Numeric T>
+    std::shared_ptr<const FrozenGraph<T>> freeze(Graph<T>&& G) {
+        return std::make_shared<const FrozenGraph<T>>(std::move(G));
+    }
+
+} // namespace cg
@@ -0,0 +1,292 @@
+#pragma once
+#include "expression.hpp"
+#include "frozen_graph.hpp"
+#include "identical.hpp"
+#include "eval/batch.hpp"
+#include "eval/scratch.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace cg {
+
+    // a subgraph defined once and called from other graphs. its body is a graph of its own whose
+    // InputNodes named in `params` are the parameters, `outputs` are the values it returns.
+    // the body gets frozen on construction, every call runs that one compiled body.
+    // a body run produces every output at once. with more than one output the last run per thread
+    // is kept, so the other outputs of the same call (call() adds them next to each other) don't
+    // run the body again
+    template<Numeric T>
+    class Function {
+    public:
+        Function(std::string name, Graph<T> body, std::vector<std::string> params, std::vector<NodeID> outputs)
+            : name_(std::move(name)), body_(std::move(body)), params_(std::move(params)), outputs_(std::move(outputs)) {
+            for (auto out : outputs_) {
+                if (out.index() >= body_.size()) {
+                    throw std::runtime_error("output of function " + name_ + " is not part of its body");
+                }
+            }
+            slot_of_.resize(params_.size(), FrozenGraph<T>::npos);
+            for (std::size_t p = 0; p < params_.size(); ++p) {
+                slot_of_[p] = body_.slot(params_[p]);
+            }
+            for (std::size_t s = 0; s < body_.inputs().size(); ++s) {
+                if (std::find(slot_of_.begin(), slot_of_.end(), s) == slot_of_.end()) {
+                    throw std::runtime_error("input " + body_.input_name(s) + " of function " + name_ +
+                                             " is not one of its parameters");
+                }
+            }
+        }
+
+        const std::string& name() const noexcept { return name_; }
+        const FrozenGraph<T>& body() const noexcept { return body_; }
+        const std::vector<std::string>& params() const noexcept { return params_; }
+        std::span<const NodeID> outputs() const noexcept { return outputs_; }
+        std::size_t arity() const noexcept { return params_.size(); }
+
+        // evaluates output `output` with arg(p) supplying parameter p
+        template<typename Arg>
+        T invoke(Arg&& arg, std::size_t output) const {
+            auto value = [&](std::size_t p, std::size_t) { return arg(p); };
+            if (remembered(1, value)) return last_call().outputs[output];
+
+            // nested calls in the body use the memo too, so the results stay in a frame until the end
+            auto frame = eval::Scratch<T>::acquire(body_.inputs().size() + outputs_.size());
+            auto slots = frame.values().first(body_.inputs().size());
+            auto outs = frame.values().subspan(body_.inputs().size());
+            for (std::size_t p = 0; p < params_.size(); ++p) {
+                if (slot_of_[p] != FrozenGraph<T>::npos) {
+                    slots[slot_of_[p]] = arg(p);
+                }
+            }
+            body_.evaluate(outputs_, slots, outs);
+            remember(1, value, outs);
+            return outs[output];
+        }
+
+        // output `output` for `rows` rows at once, arg(p) points at parameter p's rows.
+        // the body is swept node at a time over blocks of rows, like a frozen graph in bulk_evaluate
+        template<typename Arg>
+        void invoke_batch(Arg&& arg, std::size_t rows, std::size_t output, T* out) const {
+            auto value = [&](std::size_t p, std::size_t r) -> const T& { return arg(p)[r]; };
+            if (remembered(rows, value)) {
+                std::copy_n(last_call().outputs.begin() + output * rows, rows, out);
+                return;
+            }
+
+            auto results = eval::Scratch<T>::acquire(outputs_.size() * rows);
+            const std::size_t chunk = std::min(eval::block_rows<T>(body_.size()), rows);
+            auto frame = eval::Scratch<T>::acquire(body_.size() * chunk);
+            auto pointers = eval::Scratch<T*>::acquire(body_.size());
+            eval::bind_columns(frame.values(), chunk, pointers.values());
+            auto columns = pointers.values();
+
+            for (std::size_t first = 0; first < rows; first += chunk) {
+                const std::size_t n = std::min(chunk, rows - first);
+                // parameters are read straight out of the caller's columns
+                for (std::size_t p = 0; p < params_.size(); ++p) {
+                    if (slot_of_[p] != FrozenGraph<T>::npos) {
+                        columns[body_.inputs()[slot_of_[p]].index()] = const_cast<T*>(arg(p) + first);
+                    }
+                }
+                eval::evaluate_block(body_.graph(), body_.ops(), columns, n);
+                for (std::size_t k = 0; k < outputs_.size(); ++k) {
+                    std::copy_n(columns[outputs_[k].index()], n, results.values().data() + k * rows + first);
+                }
+            }
+            remember(rows, value, results.values());
+            std::copy_n(results.values().data() + output * rows, rows, out);
+        }
+
+        T operator()(std::span<const T> args, std::size_t output = 0) const {
+            return invoke([&](std::size_t p) { return args[p]; }, output);
+        }
+
+    private:
+        // the last body run on this thread: which function, its arguments and every output,
+        // parameter-major and output-major with `rows` values each
+        struct Memo {
+            std::uint64_t fn = 0;
+            std::size_t rows = 0;
+            std::vector<T> args;
+            std::vector<T> outputs;
+        };
+
+        static Memo& last_call() {
+            thread_local Memo memo;
+            return memo;
+        }
+
+        // value(p, r) is row r of parameter p. arguments have to be identical(), == would hand
+        // the result for +0.0 to a call on -0.0. value types that can't be compared never match,
+        // and neither do single-output functions: no sibling output could pick their run up
+        template<typename Value>
+        bool remembered(std::size_t rows, Value&& value) const {
+            if constexpr (Identifiable<T>) {
+                if (outputs_.size() < 2) return false;
+                const auto& memo = last_call();
+                if (memo.fn != id_ || memo.rows != rows) return false;
+                for (std::size_t p = 0; p < params_.size(); ++p) {
+                    for (std::size_t r = 0; r < rows; ++r) {
+                        if (!identical(memo.args[p * rows + r], value(p, r))) return false;
+                    }
+                }
+                return true;
+            } else {
+                return false;
+            }
+        }
+
+        template<typename Value>
+        void remember(std::size_t rows, Value&& value, std::span<const T> outputs) const {
+            if constexpr (Identifiable<T>) {
+                if (outputs_.size() < 2) return;
+                auto& memo = last_call();
+                memo.fn = id_;
+                memo.rows = rows;
+                memo.args.resize(params_.size() * rows);
+                for (std::size_t p = 0; p < params_.size(); ++p) {
+                    for (std::size_t r = 0; r < rows; ++r) memo.args[p * rows + r] = value(p, r);
+                }
+                memo.outputs.assign(outputs.begin(), outputs.begin() + outputs_.size() * rows);
+            }
+        }
+
+        // addresses get reused, ids don't
+        static inline std::atomic<std::uint64_t> next_id_{1};
+
+        std::string name_;
+        FrozenGraph<T> body_;
+        std::vector<std::string> params_;
+        std::vector<NodeID> outputs_;
+        std::vector<std::size_t> slot_of_; // parameter -> input slot of the frozen body
+        std::uint64_t id_ = next_id_.fetch_add(1, std::memory_order_relaxed);
+    };
+
+    template<Numeric T>
+    std::shared_ptr<const Function<T>> make_function(std::string name, Graph<T> body,
+                                                     std::vector<std::string> params, std::vector<NodeID> outputs) {
+        return std::make_shared<const Function<T>>(std::move(name), std::move(body), std::move(params), std::move(outputs));
+    }
+
+    // one output of a call to a shared function, the arguments are ordinary graph nodes
+    template<Numeric T>
+    class CallNode final : public Node<T> {
+    public:
+        CallNode(std::shared_ptr<const Function<T>> fn, std::vector<NodeID> args, std::size_t output = 0)
+            : fn_(std::move(fn)), args_(std::move(args)), output_(output) {
+            if (args_.size() != fn_->arity()) {
+                throw std::runtime_error("function " + fn_->name() + " takes " + std::to_string(fn_->arity()) +
+                                         " arguments, got " + std::to_string(args_.size()));
+            }
+        }
+
+        std::string_view kind() const noexcept override { return "call"; }
+
+        std::span<const NodeID> inputs() const noexcept override { return args_; }
+
+        T evaluate_from_cache(std::span<const T> values) const override {
+            return fn_->invoke([&](std::size_t p) { return values[args_[p].index()]; }, output_);
+        }
+
+        void evaluate_batch(std::span<const T* const> columns, std::span<T> out) const override {
+            fn_->invoke_batch([&](std::size_t p) { return columns[args_[p].index()]; }, out.size(), output_, out.data());
+        }
+
+        // same function + same arguments + same output = same node
+        std::size_t hash() const noexcept override {
+            std::size_t h = std::hash<const void*>{}(fn_.get());
+            for (auto a : args_) hash_combine(h, a.index());
+            hash_combine(h, output_);
+            return h;
+        }
+
+        bool is_equivalent(const Node<T>& other) const noexcept override {
+            if (auto* c = dynamic_cast<const CallNode*>(&other)) {
+                return fn_ == c->fn_ && args_ == c->args_ && output_ == c->output_;
+            }
+            return false;
+        }
+
+        std::string label() const noexcept override {
+            return fn_->outputs().size() > 1 ? fn_->name() + "[" + std::to_string(output_) + "]" : fn_->name();
+        }
+
+        // the body is shared, only this call's own bookkeeping counts
+        std::size_t footprint() const noexcept override {
+            return sizeof(*this) + args_.capacity() * sizeof(NodeID);
+        }
+
+        std::unique_ptr<Node<T>> with_inputs(std::span<const NodeID> inputs) const override {
+            return std::make_unique<CallNode>(fn_, std::vector<NodeID>(inputs.begin(), inputs.end()), output_);
+        }
+
+        const std::shared_ptr<const Function<T>>& function() const noexcept { return fn_; }
+        std::size_t output() const noexcept { return output_; }
+
+    private:
+        std::shared_ptr<const Function<T>> fn_;
+        std::vector<NodeID> args_;
+        std::size_t output_;
+    };
+
+    enum class CallMode {
+        shared,  // one call node per output, all evaluating the function's single compiled body
+        inlined, // the body's nodes are copied into the caller's graph (and go through its cse)
+    };
+
+    // calls `fn` on `args` in G and returns one expression per output of the function.
+    // inlining trades graph size for letting the callee's nodes fold and share with the caller's
+    template<Numeric T>
+    std::vector<Expression<T>> call(Graph<T>& G, const std::shared_ptr<const Function<T>>& fn,
+                                    const std::vector<Expression<T>>& args, CallMode mode = CallMode::shared) {
+        std::vector<NodeID> ids;
+        for (const auto& a : args) {
+            assert(&a.graph() == &G && "cannot combine expressions from different graphs :(");
+            ids.push_back(a.root());
+        }
+
+        std::vector<Expression<T>> results;
+        if (mode == CallMode::shared) {
+            for (std::size_t k = 0; k < fn->outputs().size(); ++k) {
+                results.emplace_back(&G, G.add(std::make_unique<CallNode<T>>(fn, ids, k)));
+            }
+            return results;
+        }
+
+        // copy the body over in execution order, parameters map onto the arguments
+        const auto& body = fn->body();
+        std::vector<NodeID> mapped(body.size());
+        for (std::size_t p = 0; p < fn->arity(); ++p) {
+            const std::size_t s = body.slot(fn->params()[p]);
+            if (s != FrozenGraph<T>::npos) mapped[body.inputs()[s].index()] = ids[p];
+        }
+        std::vector<NodeID> ins;
+        for (auto id : body.ops()) {
+            const auto& node = body.node(id);
+            ins.clear();
+            for (auto dep : node.inputs()) ins.push_back(mapped[dep.index()]);
+            mapped[id.index()] = G.add(node.with_inputs(ins));
+        }
+        for (auto out : fn->outputs()) {
+            results.emplace_back(&G, mapped[out.index()]);
+        }
+        return results;
+    }
+
+    // same, in the graph of the arguments. a function without parameters needs the overload above
+    template<Numeric T>
+    std::vector<Expression<T>> call(const std::shared_ptr<const Function<T>>& fn,
+                                    const std::vector<Expression<T>>& args, CallMode mode = CallMode::shared) {
+        if (args.empty()) {
+            throw std::runtime_error("calling " + fn->name() + " without arguments needs the graph, use call(G, fn, {})");
+        }
+        return call(args.front().graph(), fn, args, mode);
+    }
+
+} // namespace cg
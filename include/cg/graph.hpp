@@ -2,104 +2,409 @@
 #include "concepts.hpp"
 #include "node.hpp"
 
+#include <algorithm>
 #include <memory>
-#include <queue>
-
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 namespace cg {
 
-    // owns nodes and provides building & traversal utilities
+    // bytes a graph holds, by component. node objects report themselves through Node::footprint,
+    // containers are estimated from their sizes and capacities; allocator headers aren't counted
+    struct GraphMemory {
+        std::size_t nodes = 0;      // node objects, input names excluded
+        std::size_t names = 0;      // input names too long for the string's inline buffer
+        std::size_t node_table = 0; // one owning pointer per id slot, removed ones included
+        std::size_t cse_table = 0;  // intern table buckets and entries, plus the hash kept per node
+        std::size_t consumers = 0;  // consumer lists
+        std::size_t order = 0;      // topological order, positions and search marks
+
+        std::size_t total() const noexcept {
+            return nodes + names + node_table + cse_table + consumers + order;
+        }
+    };
 
+    // owns nodes and provides building & traversal utilities.
+    // besides the nodes the graph keeps the cse table, every node's consumers and a topological
+    // order up to date through edits, so replacing, rewiring or removing a node only touches the
+    // part of the graph between the edited node and its new inputs (plus the consumer lists of the
+    // inputs it gains or loses), never the whole thing.
+    // removed nodes leave a tombstone behind: ids stay stable, see alive()
     template<Numeric T>
     class Graph {
     public:
         using value_type = T;
 
+        // id slots, including removed ones. size a per-node buffer with this
         std::size_t size() const { return nodes_.size(); }
 
+        // nodes that haven't been removed
+        std::size_t live() const { return nodes_.size() - removed_; }
+
+        bool alive(NodeID id) const noexcept {
+            return id.index() < nodes_.size() && nodes_[id.index()] != nullptr;
+        }
+
         const Node<T>& node(NodeID id) const {
-            return *nodes_.at(id.index());
+            return *checked(id);
         }
 
         Node<T>& node(NodeID id) {
-            return *nodes_.at(id.index());
+            return *checked(id);
+        }
+
+        // every node that takes `id` as an input, once per edge (x * x lists the product twice)
+        std::span<const NodeID> consumers(NodeID id) const {
+            checked(id);
+            return consumers_[id.index()];
         }
 
         NodeID add(std::unique_ptr<Node<T>> node) {
+            require_inputs(*node);
             auto h = node->hash();
+            if (auto existing = find(*node, h)) {
+                return *existing;
+            }
+            return insert(std::move(node), h);
+        }
+
+        // cse lookup before allocating: the node is built on the stack and only moved to the heap if it's new
+        template<typename N, typename... Args>
+        NodeID emplace(Args&&... args) {
+            N probe(std::forward<Args>(args)...);
+            require_inputs(probe);
+            auto h = probe.hash();
+            if (auto existing = find(probe, h)) {
+                return *existing;
+            }
+            return insert(std::make_unique<N>(std::move(probe)), h);
+        }
+
+        // the node equivalent to `probe` if the graph already has one
+        std::optional<NodeID> find(const Node<T>& probe) const {
+            return find(probe, probe.hash());
+        }
+
+        // swaps the node behind `id`, consumers keep pointing at it. the cse table forgets the old
+        // node and learns the new one, and the order is repaired if a new input sits after `id`.
+        // throws, leaving the graph untouched, if the new inputs would close a cycle.
+        // an old input that loses its last consumer stays in the graph, see remove()
+        void replace(NodeID id, std::unique_ptr<Node<T>> node) {
+            checked(id);
+            require_inputs(*node);
+            const auto next = node->inputs();
+            if (closes_cycle(id, next)) throw std::runtime_error("replacing node " + std::to_string(id.index()) + " would create a cycle");
+
+            for (auto dep : nodes_[id.index()]->inputs()) unlink(dep, id);
+            uncache(id);
+
+            const auto h = node->hash();
+            nodes_[id.index()] = std::move(node);
+            hashes_[id.index()] = h;
+            cache_.insert(std::make_pair(h, id));
+
+            for (auto dep : nodes_[id.index()]->inputs()) {
+                consumers_[dep.index()].push_back(id);
+                reorder(dep, id);
+            }
+        }
 
+        // points input `slot` of `id` at `input`, through Node::with_inputs
+        void rewire(NodeID id, std::size_t slot, NodeID input) {
+            const auto& current = node(id);
+            std::vector<NodeID> inputs(current.inputs().begin(), current.inputs().end());
+            if (slot >= inputs.size()) {
+                throw std::runtime_error("node " + std::to_string(id.index()) + " has no input " + std::to_string(slot));
+            }
+            inputs[slot] = input;
+            replace(id, current.with_inputs(inputs));
+        }
+
+        // drops `id`, which must not have consumers, and then every input it leaves without one.
+        // constants go too once nothing refers to them, input nodes stay: expressions and the parser
+        // hand their ids out and build on them later. intermediate nodes don't get that treatment, the
+        // graph can't see which Expressions still point at them: an Expression whose root cascaded away
+        // throws once it's built on or read. returns how many nodes were removed
+        std::size_t remove(NodeID id) {
+            checked(id);
+            if (!consumers_[id.index()].empty()) {
+                throw std::runtime_error("node " + std::to_string(id.index()) + " still has consumers");
+            }
+            std::size_t count = 0;
+            std::vector<NodeID> pending{id};
+            while (!pending.empty()) {
+                const NodeID victim = pending.back();
+                pending.pop_back();
+                for (auto dep : nodes_[victim.index()]->inputs()) {
+                    unlink(dep, victim);
+                    // a node feeding the victim twice is queued once, when its last edge goes
+                    if (consumers_[dep.index()].empty() && nodes_[dep.index()]->kind() != "input") {
+                        pending.push_back(dep);
+                    }
+                }
+                drop(victim);
+                ++count;
+            }
+            compact();
+            return count;
+        }
+
+        // removes every node `roots` don't depend on, input nodes excepted (see remove()).
+        // walks the whole graph, prefer remove() when you know what became garbage
+        std::size_t remove_unreferenced(std::span<const NodeID> roots) {
+            std::vector<bool> reachable(nodes_.size(), false);
+            std::vector<NodeID> pending;
+            for (auto root : roots) {
+                checked(root);
+                if (!reachable[root.index()]) {
+                    reachable[root.index()] = true;
+                    pending.push_back(root);
+                }
+            }
+            while (!pending.empty()) {
+                const NodeID id = pending.back();
+                pending.pop_back();
+                for (auto dep : nodes_[id.index()]->inputs()) {
+                    if (!reachable[dep.index()]) {
+                        reachable[dep.index()] = true;
+                        pending.push_back(dep);
+                    }
+                }
+            }
+
+            std::size_t count = 0;
+            for (std::size_t i = 0; i < nodes_.size(); ++i) {
+                if (nodes_[i] && nodes_[i]->kind() == "input") reachable[i] = true;
+                if (!nodes_[i] || reachable[i]) continue;
+                for (auto dep : nodes_[i]->inputs()) unlink(dep, NodeID{i});
+                ++count;
+            }
+            for (std::size_t i = 0; i < nodes_.size(); ++i) {
+                if (nodes_[i] && !reachable[i]) drop(NodeID{i});
+            }
+            compact();
+            return count;
+        }
+
+        NodeID constant(T v) {
+            return emplace<ConstantNode<T>>(v);
+        }
+
+        NodeID input(std::string name) {
+            return emplace<InputNode<T>>(std::move(name));
+        }
+
+        // the maintained order, live nodes only. linear in the graph but no sorting
+        std::vector<NodeID> topological_sort() const {
+            std::vector<NodeID> sorted;
+            sorted.reserve(live());
+            for (auto id : order_) {
+                if (nodes_[id.index()]) sorted.push_back(id);
+            }
+            return sorted;
+        }
+
+        GraphMemory memory() const {
+            GraphMemory m;
+            for (const auto& node : nodes_) {
+                if (!node) continue;
+                const std::size_t bytes = node->footprint();
+                const std::size_t name = node->kind() == "input" ? bytes - sizeof(InputNode<T>) : 0;
+                m.nodes += bytes - name;
+                m.names += name;
+            }
+            m.node_table = nodes_.capacity() * sizeof(nodes_[0]);
+
+            // libstdc++ style: a bucket is one pointer, an entry a heap node with a next pointer
+            using Entry = typename decltype(cache_)::value_type;
+            m.cse_table = cache_.bucket_count() * sizeof(void*) + cache_.size() * (sizeof(void*) + sizeof(Entry)) +
+                          hashes_.capacity() * sizeof(std::size_t);
+
+            m.consumers = consumers_.capacity() * sizeof(consumers_[0]);
+            for (const auto& users : consumers_) m.consumers += users.capacity() * sizeof(NodeID);
+
+            m.order = order_.capacity() * sizeof(NodeID) + position_.capacity() * sizeof(std::size_t) +
+                      marks_.capacity() / 8;
+            return m;
+        }
+
+        // whether `a` comes before `b` in topological_sort(), in constant time
+        bool precedes(NodeID a, NodeID b) const {
+            checked(a);
+            checked(b);
+            return position_[a.index()] < position_[b.index()];
+        }
+
+    private:
+        const std::unique_ptr<Node<T>>& checked(NodeID id) const {
+            const auto& slot = nodes_.at(id.index());
+            if (!slot) throw std::runtime_error("node " + std::to_string(id.index()) + " was removed");
+            return slot;
+        }
+
+        // a removed id would otherwise leave the new node pointing at a tombstone
+        void require_inputs(const Node<T>& node) const {
+            for (auto dep : node.inputs()) checked(dep);
+        }
+
+        std::optional<NodeID> find(const Node<T>& probe, std::size_t h) const {
             auto range = cache_.equal_range(h);
             for (auto it = range.first; it != range.second; ++it) {
                 NodeID existing = it->second;
-                if (nodes_[existing.index()]->is_equivalent(*node)) {
+                if (nodes_[existing.index()]->is_equivalent(probe)) {
                     return existing;
                 }
             }
+            return std::nullopt;
+        }
 
+        // a new node's inputs all exist already, so appending it keeps the order valid
+        NodeID insert(std::unique_ptr<Node<T>> node, std::size_t h) {
+            NodeID new_id{nodes_.size()};
+            for (auto dep : node->inputs()) consumers_[dep.index()].push_back(new_id);
             nodes_.push_back(std::move(node));
-            NodeID new_id{nodes_.size() - 1};
-            // TODO: cache_.insert({h, new_id});
+            hashes_.push_back(h);
+            consumers_.emplace_back();
+            position_.push_back(order_.size());
+            order_.push_back(new_id);
+            marks_.push_back(false);
             cache_.insert(std::make_pair(h, new_id));
             return new_id;
         }
 
-        void replace(NodeID id, std::unique_ptr<Node<T>> node) {
-            nodes_.at(id.index()) = std::move(node);
+        void uncache(NodeID id) {
+            auto range = cache_.equal_range(hashes_[id.index()]);
+            for (auto it = range.first; it != range.second; ++it) {
+                if (it->second == id) {
+                    cache_.erase(it);
+                    return;
+                }
+            }
         }
 
-        NodeID constant(T v) {
-            return add(std::make_unique<ConstantNode<T>>(v));
+        // forgets one edge dep -> id
+        void unlink(NodeID dep, NodeID id) {
+            auto& users = consumers_[dep.index()];
+            auto it = std::find(users.begin(), users.end(), id);
+            *it = users.back();
+            users.pop_back();
         }
 
-        NodeID input(std::string name) {
-            return add(std::make_unique<InputNode<T>>(std::move(name)));
+        // tombstones a node whose edges are already gone, its order entry is skipped until compact()
+        void drop(NodeID id) {
+            uncache(id);
+            nodes_[id.index()].reset();
+            consumers_[id.index()].clear();
+            consumers_[id.index()].shrink_to_fit();
+            ++removed_;
         }
 
-        // kahn
-        std::vector<NodeID> topological_sort() const {
-            std::vector<size_t> indegree(nodes_.size(), 0);
-            std::vector<std::vector<size_t>> adj(nodes_.size());
+        // squeezes tombstones out of the order once they make up half of it, amortized constant per removal
+        void compact() {
+            if (2 * (order_.size() - live()) <= order_.size()) return;
+            std::erase_if(order_, [&](NodeID id) { return !nodes_[id.index()]; });
+            for (std::size_t p = 0; p < order_.size(); ++p) position_[order_[p].index()] = p;
+        }
 
-            for (size_t i = 0; i < nodes_.size(); ++i) {
-                for (const auto& dep : nodes_[i]->inputs()) {
-                    adj[dep.index()].push_back(i);
-                    ++indegree[i];
+        // would `id` taking `inputs` close a cycle, i.e. is one of them `id` or downstream of it.
+        // only inputs ordered after `id` can be, and the search stops at the last of them
+        bool closes_cycle(NodeID id, std::span<const NodeID> inputs) {
+            std::size_t bound = 0;
+            bool any = false;
+            for (auto dep : inputs) {
+                if (dep == id) return true;
+                if (position_[dep.index()] > position_[id.index()]) {
+                    bound = std::max(bound, position_[dep.index()]);
+                    any = true;
                 }
             }
+            if (!any) return false;
+
+            auto visited = forward(id, bound);
+            bool cycle = false;
+            for (auto dep : inputs) cycle = cycle || marks_[dep.index()];
+            for (auto v : visited) marks_[v.index()] = false;
+            return cycle;
+        }
 
-            std::queue<size_t> q;
-            for (size_t i = 0; i < nodes_.size(); ++i) {
-                if (indegree[i] == 0) {
-                    q.push(i);
+        // nodes reachable from `from` through consumers without going past position `bound`, marked
+        std::vector<NodeID> forward(NodeID from, std::size_t bound) {
+            std::vector<NodeID> visited{from}, pending{from};
+            marks_[from.index()] = true;
+            while (!pending.empty()) {
+                const NodeID id = pending.back();
+                pending.pop_back();
+                for (auto user : consumers_[id.index()]) {
+                    if (!marks_[user.index()] && position_[user.index()] <= bound) {
+                        marks_[user.index()] = true;
+                        visited.push_back(user);
+                        pending.push_back(user);
+                    }
                 }
             }
+            return visited;
+        }
 
-            std::vector<NodeID> sorted;
-            sorted.reserve(nodes_.size());
-
-            while (!q.empty()) {
-                size_t u = q.front();
-                q.pop();
-                sorted.push_back(NodeID{u});
-
-                for (size_t v : adj[u]) {
-                    --indegree[v];
-                    if (indegree[v] == 0) {
-                        q.push(v);
+        // nodes `from` depends on without going before position `bound`, marked
+        std::vector<NodeID> backward(NodeID from, std::size_t bound) {
+            std::vector<NodeID> visited{from}, pending{from};
+            marks_[from.index()] = true;
+            while (!pending.empty()) {
+                const NodeID id = pending.back();
+                pending.pop_back();
+                for (auto dep : nodes_[id.index()]->inputs()) {
+                    if (!marks_[dep.index()] && position_[dep.index()] >= bound) {
+                        marks_[dep.index()] = true;
+                        visited.push_back(dep);
+                        pending.push_back(dep);
                     }
                 }
             }
+            return visited;
+        }
 
-            if (sorted.size() != nodes_.size()) {
-                throw std::runtime_error("graph contains a cycle >:(");
-            }
+        // pearce-kelly: after adding the edge dep -> id, if dep sits after id, only the nodes between
+        // the two positions that are downstream of id or upstream of dep move. they're shuffled
+        // among their own positions, upstream ones first, so nothing outside that window changes
+        void reorder(NodeID dep, NodeID id) {
+            const std::size_t lower = position_[id.index()], upper = position_[dep.index()];
+            if (upper < lower) return;
 
-            return sorted;
+            auto downstream = forward(id, upper);
+            auto upstream = backward(dep, lower);
+            auto by_position = [&](NodeID a, NodeID b) { return position_[a.index()] < position_[b.index()]; };
+            std::sort(downstream.begin(), downstream.end(), by_position);
+            std::sort(upstream.begin(), upstream.end(), by_position);
+
+            std::vector<std::size_t> slots;
+            slots.reserve(upstream.size() + downstream.size());
+            for (auto v : upstream) slots.push_back(position_[v.index()]);
+            for (auto v : downstream) slots.push_back(position_[v.index()]);
+            std::sort(slots.begin(), slots.end());
+
+            std::size_t next = 0;
+            for (auto list : {&upstream, &downstream}) {
+                for (auto v : *list) {
+                    marks_[v.index()] = false;
+                    position_[v.index()] = slots[next];
+                    order_[slots[next++]] = v;
+                }
+            }
         }
 
-    private:
-        std::vector<std::unique_ptr<Node<T>>> nodes_;
+        std::vector<std::unique_ptr<Node<T>>> nodes_; // nullptr once removed
+        std::vector<std::size_t> hashes_;             // what each node was cached under
+        std::vector<std::vector<NodeID>> consumers_;
+        std::vector<NodeID> order_;                   // topological, may still hold removed ids
+        std::vector<std::size_t> position_;           // index into order_ per node
+        std::vector<bool> marks_;                     // scratch for the searches, all false between edits
+        std::size_t removed_ = 0;
         std::unordered_multimap<std::size_t, NodeID> cache_;
     };
 
-} // namespace cg
\ No newline at end of file
+} // namespace cg
@@ -0,0 +1,36 @@
+#pragma once
+#include <bit>
+#include <cmath>
+#include <concepts>
+#include <cstdint>
+
+namespace cg {
+
+    // identical(a, b): a and b hold the same value bit for bit, so anything computed from one gives
+    // the same result from the other. unlike ==, -0.0 and +0.0 differ (1 / x tells them apart) and a
+    // nan matches itself. the call and scan memos key on this.
+    // composite values (Dual, Taylor, Tensor) overload it next to their definition and compare part by part
+    template<std::equality_comparable T>
+    bool identical(const T& a, const T& b) {
+        if constexpr (std::floating_point<T> && sizeof(T) == sizeof(std::uint64_t)) {
+            return std::bit_cast<std::uint64_t>(a) == std::bit_cast<std::uint64_t>(b);
+        } else if constexpr (std::floating_point<T> && sizeof(T) == sizeof(std::uint32_t)) {
+            return std::bit_cast<std::uint32_t>(a) == std::bit_cast<std::uint32_t>(b);
+        } else if constexpr (std::floating_point<T>) {
+            // long double carries padding bytes, so compare what the value means instead
+            if (std::isnan(a) || std::isnan(b)) return std::isnan(a) && std::isnan(b);
+            return a == b && std::signbit(a) == std::signbit(b);
+        } else {
+            return a == b;
+        }
+    }
+
+    // value types whose memo lookups can hit, see Function and ScanNode
+    template<typename T>
+    concept Identifiable =
+        requires (const T& a, const T& b)
+    {
+        { identical(a, b) } -> std::convertible_to<bool>;
+    };
+
+} // namespace cg
@@ -0,0 +1,264 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace cg::io {
+
+    // a minimal column-major binary format:
+    //
+    //   magic      8 bytes  "cgcols02"
+    //   rows       uint64
+    //   cols       uint64
+    //   elem_size  uint64   sizeof the stored value type
+    //   names      cols x { uint32 length, length bytes }
+    //   padding    up to the next multiple of columnar_alignment
+    //   data       cols x rows values, one column after the other
+    //
+    // integers are stored in native byte order. the header is padded to a fixed 64 KiB rather than the
+    // host's page size, so columns start on a page boundary on any machine that reads the file back
+
+    inline constexpr char columnar_magic[8] = {'c', 'g', 'c', 'o', 'l', 's', '0', '2'};
+    inline constexpr std::size_t columnar_alignment = std::size_t(1) << 16;
+
+    inline std::size_t page_size() noexcept {
+        return static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+    }
+
+    // an owning shared mapping of a whole file
+    class MappedFile {
+    public:
+        MappedFile() = default;
+
+        static MappedFile open_read(const std::string& path) {
+            int fd = ::open(path.c_str(), O_RDONLY);
+            if (fd < 0) throw std::runtime_error("cannot open " + path);
+            struct stat st{};
+            if (::fstat(fd, &st) != 0) {
+                ::close(fd);
+                throw std::runtime_error("cannot stat " + path);
+            }
+            return MappedFile(fd, static_cast<std::size_t>(st.st_size), PROT_READ, path);
+        }
+
+        // creates (or truncates) the file and sizes it, the kernel hands out zeroed pages lazily
+        static MappedFile create(const std::string& path, std::size_t size) {
+            int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+            if (fd < 0) throw std::runtime_error("cannot create " + path);
+            if (::ftruncate(fd, static_cast<off_t>(size)) != 0) {
+                ::close(fd);
+                throw std::runtime_error("cannot resize " + path);
+            }
+            return MappedFile(fd, size, PROT_READ | PROT_WRITE, path);
+        }
+
+        MappedFile(MappedFile&& other) noexcept { *this = std::move(other); }
+
+        MappedFile& operator=(MappedFile&& other) noexcept {
+            if (this != &other) {
+                release();
+                data_ = std::exchange(other.data_, nullptr);
+                size_ = std::exchange(other.size_, 0);
+                fd_ = std::exchange(other.fd_, -1);
+            }
+            return *this;
+        }
+
+        ~MappedFile() { release(); }
+
+        std::byte* data() const noexcept { return data_; }
+        std::size_t size() const noexcept { return size_; }
+
+        // readahead hint for every page touching [offset, offset + length), returns immediately
+        void prefetch(std::size_t offset, std::size_t length) const noexcept {
+            auto [begin, len] = page_range(offset, length, true);
+            if (len) ::madvise(data_ + begin, len, MADV_WILLNEED);
+        }
+
+        // drops the pages lying entirely inside [offset, offset + length) from this mapping so resident
+        // memory stays bounded. dirty pages of a shared mapping aren't lost, the page cache still holds them
+        void evict(std::size_t offset, std::size_t length) const noexcept {
+            auto [begin, len] = page_range(offset, length, false);
+            if (len) ::madvise(data_ + begin, len, MADV_DONTNEED);
+        }
+
+        // starts writeback of every dirty page touching [offset, offset + length) without waiting for it
+        void flush(std::size_t offset, std::size_t length) const noexcept {
+            auto [begin, len] = page_range(offset, length, true);
+            if (len) ::msync(data_ + begin, len, MS_ASYNC);
+        }
+
+        // blocks until every dirty page reached the file
+        void sync() const {
+            if (data_ && ::msync(data_, size_, MS_SYNC) != 0) {
+                throw std::runtime_error("msync failed");
+            }
+        }
+
+    private:
+        MappedFile(int fd, std::size_t size, int prot, const std::string& path) : size_(size), fd_(fd) {
+            if (size_ == 0) return;
+            void* p = ::mmap(nullptr, size_, prot, MAP_SHARED, fd_, 0);
+            if (p == MAP_FAILED) {
+                ::close(fd_);
+                fd_ = -1;
+                throw std::runtime_error("cannot map " + path);
+            }
+            data_ = static_cast<std::byte*>(p);
+        }
+
+        // page aligned cover of [offset, offset + length), either every page touching it (outward)
+        // or only the pages lying entirely inside it
+        std::pair<std::size_t, std::size_t> page_range(std::size_t offset, std::size_t length,
+                                                       bool outward) const noexcept {
+            const std::size_t page = page_size();
+            const std::size_t last = std::min(size_, offset + length);
+            std::size_t begin = (offset + page - 1) / page * page;
+            std::size_t end = last / page * page;
+            if (outward) {
+                begin = offset / page * page;
+                end = std::min(size_, (last + page - 1) / page * page);
+            }
+            return {begin, end > begin ? end - begin : 0};
+        }
+
+        void release() noexcept {
+            if (data_) ::munmap(data_, size_);
+            if (fd_ >= 0) ::close(fd_);
+            data_ = nullptr;
+            fd_ = -1;
+        }
+
+        std::byte* data_ = nullptr;
+        std::size_t size_ = 0;
+        int fd_ = -1;
+    };
+
+    // typed view over a mapped columnar file
+    template<typename T>
+    class ColumnarFile {
+    public:
+        // maps an existing file for reading
+        static ColumnarFile open(const std::string& path) {
+            ColumnarFile f;
+            f.file_ = MappedFile::open_read(path);
+            f.parse(path);
+            return f;
+        }
+
+        // creates a file with the given columns, values start out as zero
+        static ColumnarFile create(const std::string& path, std::size_t rows, std::vector<std::string> names) {
+            const std::size_t header = header_size(names);
+            ColumnarFile f;
+            f.file_ = MappedFile::create(path, header + names.size() * rows * sizeof(T));
+            f.rows_ = rows;
+            f.data_offset_ = header;
+
+            std::byte* p = f.file_.data();
+            const std::uint64_t fields[3] = {rows, names.size(), sizeof(T)};
+            std::memcpy(p, columnar_magic, sizeof(columnar_magic));
+            std::memcpy(p + sizeof(columnar_magic), fields, sizeof(fields));
+            p += sizeof(columnar_magic) + sizeof(fields);
+            for (const auto& name : names) {
+                const auto len = static_cast<std::uint32_t>(name.size());
+                std::memcpy(p, &len, sizeof(len));
+                std::memcpy(p + sizeof(len), name.data(), len);
+                p += sizeof(len) + len;
+            }
+            f.names_ = std::move(names);
+            return f;
+        }
+
+        std::size_t rows() const noexcept { return rows_; }
+        std::size_t cols() const noexcept { return names_.size(); }
+        const std::vector<std::string>& names() const noexcept { return names_; }
+        const MappedFile& file() const noexcept { return file_; }
+
+        std::size_t column_index(std::string_view name) const {
+            for (std::size_t c = 0; c < names_.size(); ++c) {
+                if (names_[c] == name) return c;
+            }
+            throw std::runtime_error("no column named " + std::string(name));
+        }
+
+        // byte offset of row `row` of column `col` within the file
+        std::size_t offset(std::size_t col, std::size_t row = 0) const noexcept {
+            return data_offset_ + (col * rows_ + row) * sizeof(T);
+        }
+
+        std::span<const T> column(std::size_t col) const noexcept {
+            return {reinterpret_cast<const T*>(file_.data() + offset(col)), rows_};
+        }
+
+        std::span<T> column(std::size_t col) noexcept {
+            return {reinterpret_cast<T*>(file_.data() + offset(col)), rows_};
+        }
+
+    private:
+        static std::size_t header_size(const std::vector<std::string>& names) {
+            std::size_t bytes = sizeof(columnar_magic) + 3 * sizeof(std::uint64_t);
+            for (const auto& name : names) bytes += sizeof(std::uint32_t) + name.size();
+            return (bytes + columnar_alignment - 1) / columnar_alignment * columnar_alignment;
+        }
+
+        void parse(const std::string& path) {
+            const std::byte* p = file_.data();
+            const std::byte* end = p + file_.size();
+            auto need = [&](std::size_t n) {
+                if (static_cast<std::size_t>(end - p) < n) throw std::runtime_error("truncated columnar file: " + path);
+            };
+
+            need(sizeof(columnar_magic) + 3 * sizeof(std::uint64_t));
+            if (std::memcmp(p, columnar_magic, sizeof(columnar_magic)) != 0) {
+                throw std::runtime_error("not a columnar file: " + path);
+            }
+            std::uint64_t fields[3];
+            std::memcpy(fields, p + sizeof(columnar_magic), sizeof(fields));
+            p += sizeof(columnar_magic) + sizeof(fields);
+            if (fields[2] != sizeof(T)) {
+                throw std::runtime_error("element size mismatch in " + path);
+            }
+
+            // every name takes at least its length field, which bounds a count we can't trust yet
+            if (fields[1] > static_cast<std::size_t>(end - p) / sizeof(std::uint32_t)) {
+                throw std::runtime_error("truncated columnar file: " + path);
+            }
+            rows_ = fields[0];
+            names_.reserve(fields[1]);
+            for (std::uint64_t c = 0; c < fields[1]; ++c) {
+                std::uint32_t len;
+                need(sizeof(len));
+                std::memcpy(&len, p, sizeof(len));
+                p += sizeof(len);
+                need(len);
+                names_.emplace_back(reinterpret_cast<const char*>(p), len);
+                p += len;
+            }
+
+            // divide instead of multiplying, a crafted row count would wrap the product
+            data_offset_ = header_size(names_);
+            if (file_.size() < data_offset_ ||
+                (!names_.empty() && rows_ > (file_.size() - data_offset_) / sizeof(T) / names_.size())) {
+                throw std::runtime_error("truncated columnar file: " + path);
+            }
+        }
+
+        MappedFile file_;
+        std::size_t rows_ = 0;
+        std::size_t data_offset_ = 0;
+        std::vector<std::string> names_;
+    };
+
+} // namespace cg::io
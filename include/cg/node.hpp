@@ -2,10 +2,14 @@
 #include "concepts.hpp"
 #include "node_id.hpp"
 
+#include <algorithm>
+#include <array>
 #include <span>
+#include <stdexcept>
 #include <string>
 #include <vector>
 #include <functional>
+#include <memory>
 #include <typeinfo>
 #include <sstream>
 #include <iomanip>
@@ -16,6 +20,14 @@ namespace cg {
         seed ^= value + 0x9e3779b9 + (seed << 6) + (seed >> 2);
     }
 
+    // in-place evaluation hooks: out = o(x) and out = o(x, y), for value types that can reuse out's
+    // storage instead of building a fresh value. these defaults just assign, tensor.hpp overloads them
+    template<typename O, typename T>
+    void apply_into(const O& o, const T& x, T& out) { out = o(x); }
+
+    template<typename O, typename T>
+    void apply_into(const O& o, const T& x, const T& y, T& out) { out = o(x, y); }
+
     // a runtime-polymorphic base for all node types
     template<Numeric T>
     class Node {
@@ -35,7 +47,33 @@ namespace cg {
         // uses precomputed values[child.index()] to avoid recursion when computing its own value
         virtual T evaluate_from_cache(std::span<const T> values) const = 0;
 
+        // same as evaluate_from_cache, but writes into an existing value so types owning memory
+        // (see Tensor) reuse it. evaluators go through this one
+        virtual void evaluate_into(std::span<const T> values, T& out) const {
+            out = evaluate_from_cache(values);
+        }
+
+        // evaluates out.size() rows at once, columns[child.index()] points at the child's rows.
+        // the default goes row by row through evaluate_into, the built-in nodes override it
+        virtual void evaluate_batch(std::span<const T* const> columns, std::span<T> out) const {
+            std::vector<T> values(columns.size());
+            for (std::size_t r = 0; r < out.size(); ++r) {
+                for (auto dep : inputs()) values[dep.index()] = columns[dep.index()][r];
+                evaluate_into(values, out[r]);
+            }
+        }
+
         virtual std::string label() const noexcept = 0;
+
+        // bytes owned by the node object, including anything it keeps on the heap.
+        // the default only knows the base object, node types with more state override it
+        virtual std::size_t footprint() const noexcept { return sizeof(Node); }
+
+        // a copy of this node reading from `inputs` instead, leaves have none and are copied as they are.
+        // rewiring and inlining need it, node types without one throw
+        virtual std::unique_ptr<Node> with_inputs(std::span<const NodeID>) const {
+            throw std::runtime_error("node kind " + std::string(kind()) + " can't be copied onto new inputs");
+        }
     };
 
     template<Numeric T>
@@ -45,7 +83,12 @@ namespace cg {
 
         std::string_view kind() const noexcept override { return "const"; }
         std::span<const NodeID> inputs() const noexcept override { return {}; }
-        T evaluate_from_cache(std::span<const T> values) const override { return value_; }
+        T evaluate_from_cache(std::span<const T>) const override { return value_; }
+        void evaluate_into(std::span<const T>, T& out) const override { out = value_; }
+
+        void evaluate_batch(std::span<const T* const>, std::span<T> out) const override {
+            std::fill(out.begin(), out.end(), value_);
+        }
 
         // constants are equal if values are equal
         std::size_t hash() const noexcept override {
@@ -61,12 +104,18 @@ namespace cg {
 
         T value() const noexcept { return value_; }
 
+        std::unique_ptr<Node<T>> with_inputs(std::span<const NodeID>) const override {
+            return std::make_unique<ConstantNode>(value_);
+        }
+
         std::string label() const noexcept override {
             std::ostringstream oss;
             oss << value_;
             return oss.str();
         }
 
+        std::size_t footprint() const noexcept override { return sizeof(*this); }
+
     private:
         T value_;
     };
@@ -79,7 +128,11 @@ namespace cg {
         std::string_view kind() const noexcept override { return "input"; }
         std::span<const NodeID> inputs() const noexcept override { return {}; }
 
-        T evaluate_from_cache(std::span<const T> values) const override {
+        T evaluate_from_cache(std::span<const T>) const override {
+            throw std::logic_error("not implemented");
+        }
+
+        void evaluate_batch(std::span<const T* const>, std::span<T>) const override {
             throw std::logic_error("not implemented");
         }
 
@@ -96,10 +149,21 @@ namespace cg {
 
         const std::string& name() const noexcept {return name_; }
 
+        std::unique_ptr<Node<T>> with_inputs(std::span<const NodeID>) const override {
+            return std::make_unique<InputNode>(name_);
+        }
+
         std::string label() const noexcept override {
             return name_;
         }
 
+        // short names live inside the string object itself (sso), longer ones on the heap
+        std::size_t footprint() const noexcept override {
+            const auto* self = reinterpret_cast<const char*>(this);
+            const bool inline_name = name_.data() >= self && name_.data() < self + sizeof(*this);
+            return sizeof(*this) + (inline_name ? 0 : name_.capacity() + 1);
+        }
+
     private:
         std::string name_;
     };
@@ -119,6 +183,21 @@ namespace cg {
             return o_(values[in_.index()]);
         }
 
+        void evaluate_into(std::span<const T> values, T& out) const override {
+            apply_into(o_, values[in_.index()], out);
+        }
+
+        void evaluate_batch(std::span<const T* const> columns, std::span<T> out) const override {
+            const T* x = columns[in_.index()];
+            if constexpr (BatchUnaryOperation<O, T>) {
+                o_.batch(std::span<const T>(x, out.size()), out);
+            } else {
+                for (std::size_t r = 0; r < out.size(); ++r) {
+                    apply_into(o_, x[r], out[r]);
+                }
+            }
+        }
+
         // same input + same operation type = same node
         std::size_t hash() const noexcept override {
             std::size_t h = 0;
@@ -137,10 +216,16 @@ namespace cg {
         NodeID input() const noexcept { return in_; }
         const O& o() const noexcept { return o_; }
 
+        std::unique_ptr<Node<T>> with_inputs(std::span<const NodeID> inputs) const override {
+            return std::make_unique<UnaryNode>(inputs[0], o_);
+        }
+
         std::string label() const noexcept override {
             return std::string(O::symbol);
         }
 
+        std::size_t footprint() const noexcept override { return sizeof(*this); }
+
     private:
         NodeID in_;
         O o_;
@@ -164,6 +249,22 @@ namespace cg {
             return o_(values[ins_[0].index()], values[ins_[1].index()]);
         }
 
+        void evaluate_into(std::span<const T> values, T& out) const override {
+            apply_into(o_, values[ins_[0].index()], values[ins_[1].index()], out);
+        }
+
+        void evaluate_batch(std::span<const T* const> columns, std::span<T> out) const override {
+            const T* x = columns[ins_[0].index()];
+            const T* y = columns[ins_[1].index()];
+            if constexpr (BatchBinaryOperation<O, T>) {
+                o_.batch(std::span<const T>(x, out.size()), std::span<const T>(y, out.size()), out);
+            } else {
+                for (std::size_t r = 0; r < out.size(); ++r) {
+                    apply_into(o_, x[r], y[r], out[r]);
+                }
+            }
+        }
+
         // same input + same operation type = same node
         std::size_t hash() const noexcept override {
             std::size_t h = 0;
@@ -183,10 +284,16 @@ namespace cg {
         NodeID right() const noexcept { return ins_[1]; }
         const O& o() const noexcept { return o_; }
 
+        std::unique_ptr<Node<T>> with_inputs(std::span<const NodeID> inputs) const override {
+            return std::make_unique<BinaryNode>(inputs[0], inputs[1], o_);
+        }
+
         std::string label() const noexcept override {
             return std::string(O::symbol);
         }
 
+        std::size_t footprint() const noexcept override { return sizeof(*this); }
+
     private:
         std::array<NodeID, 2> ins_{};
         O o_;
@@ -0,0 +1,82 @@
+#pragma once
+#include "../graph.hpp"
+#include "../ops.hpp"
+#include "../fast_math.hpp"
+
+#include <concepts>
+#include <memory>
+
+namespace cg::opt {
+
+    namespace detail {
+
+        template<std::floating_point T, typename Exact, typename Fast>
+        bool swap_unary(const Node<T>& node, double tolerance, double absolute, fast::Function f,
+                        std::unique_ptr<Node<T>>& twin) {
+            if (!fast::within(f, tolerance, absolute)) return false;
+            if (auto* u = dynamic_cast<const UnaryNode<T, Exact>*>(&node)) {
+                twin = std::make_unique<UnaryNode<T, Fast>>(u->input());
+                return true;
+            }
+            return false;
+        }
+
+        template<std::floating_point T, typename Exact, typename Fast>
+        bool swap_binary(const Node<T>& node, double tolerance, double absolute, fast::Function f,
+                         std::unique_ptr<Node<T>>& twin) {
+            if (!fast::within(f, tolerance, absolute)) return false;
+            if (auto* b = dynamic_cast<const BinaryNode<T, Exact>*>(&node)) {
+                twin = std::make_unique<BinaryNode<T, Fast>>(b->left(), b->right());
+                return true;
+            }
+            return false;
+        }
+
+    } // namespace detail
+
+    // the approximate counterpart of `node` on the same inputs, or null when it has none
+    // (or neither documented error bound fits `tolerance` / `absolute`)
+    template<std::floating_point T>
+    std::unique_ptr<Node<T>> fast_twin(const Node<T>& node, double tolerance, double absolute = 0.0) {
+        std::unique_ptr<Node<T>> twin;
+        if (node.kind() == "unary") {
+            detail::swap_unary<T, ops::Sin, ops::fast::Sin>(node, tolerance, absolute, fast::Function::sin, twin) ||
+            detail::swap_unary<T, ops::Cos, ops::fast::Cos>(node, tolerance, absolute, fast::Function::cos, twin) ||
+            detail::swap_unary<T, ops::Exp, ops::fast::Exp>(node, tolerance, absolute, fast::Function::exp, twin) ||
+            detail::swap_unary<T, ops::Log, ops::fast::Log>(node, tolerance, absolute, fast::Function::log, twin);
+        } else if (node.kind() == "binary") {
+            detail::swap_binary<T, ops::Pow, ops::fast::Pow>(node, tolerance, absolute, fast::Function::pow, twin);
+        }
+        return twin;
+    }
+
+    // swaps the libm backed nodes of a graph for the polynomial kernels of fast_math.hpp, in place.
+    // only ops whose documented maximum relative error is within `tolerance`, or absolute error within
+    // `absolute`, get swapped, the rest (and every graph over a non floating point T, e.g. Dual) stay
+    // exact. sin and cos have no relative bound, they need an absolute tolerance to be swapped.
+    // swapped nodes keep their ids, so roots and frozen copies taken afterwards stay valid
+    template<Numeric T>
+    class FastMath {
+    public:
+        explicit FastMath(double tolerance = 1e-7, double absolute = 0.0) : tolerance_(tolerance), absolute_(absolute) {}
+
+        // returns how many nodes were swapped
+        std::size_t run(Graph<T>& G) {
+            std::size_t swapped = 0;
+            if constexpr (std::floating_point<T>) {
+                for (auto id : G.topological_sort()) {
+                    if (auto twin = fast_twin(G.node(id), tolerance_, absolute_)) {
+                        G.replace(id, std::move(twin));
+                        ++swapped;
+                    }
+                }
+            }
+            return swapped;
+        }
+
+    private:
+        double tolerance_;
+        double absolute_;
+    };
+
+} // namespace cg::opt
@@ -0,0 +1,87 @@
+#pragma once
+#include "../graph.hpp"
+
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+namespace cg::opt {
+
+    // global value numbering: cse again, after the fact. Graph::add only interns a node when it's
+    // built, so rewrites like ConstantFolding leave equal constants and, above them, nodes that have
+    // become structurally identical. this walks the topological order with a fresh table: each node
+    // first has its inputs pointed at their representatives, then either becomes the representative
+    // of its value or is merged into the one already there and removed. one pass is enough since a
+    // node's inputs are settled before it's looked at.
+    // merged nodes are gone afterwards, map ids held from before through canonical()
+    template<Numeric T>
+    class ValueNumbering {
+    public:
+        // returns how many nodes were merged
+        std::size_t run(Graph<T>& G) {
+            canonical_.resize(G.size());
+            for (std::size_t i = 0; i < G.size(); ++i) canonical_[i] = NodeID{i};
+            merged_ = removed_ = 0;
+
+            std::unordered_multimap<std::size_t, NodeID> table;
+            std::vector<NodeID> inputs;
+            for (auto id : G.topological_sort()) {
+                const auto& node = G.node(id);
+                inputs.assign(node.inputs().begin(), node.inputs().end());
+                bool moved = false;
+                for (auto& dep : inputs) {
+                    moved = moved || canonical_[dep.index()] != dep;
+                    dep = canonical_[dep.index()];
+                }
+                // representatives come earlier in the order than the node they replace, so this
+                // never has to reorder anything
+                if (moved) G.replace(id, node.with_inputs(inputs));
+
+                const auto& current = G.node(id);
+                const auto h = current.hash();
+                auto range = table.equal_range(h);
+                auto it = range.first;
+                while (it != range.second && !G.node(it->second).is_equivalent(current)) ++it;
+                if (it == range.second) {
+                    table.emplace(h, id);
+                } else {
+                    canonical_[id.index()] = it->second;
+                    ++merged_;
+                }
+            }
+
+            // consumers were all redirected on the way, so every merged node is unreferenced now
+            for (std::size_t i = 0; i < canonical_.size(); ++i) {
+                if (canonical_[i].index() != i && G.alive(NodeID{i})) removed_ += G.remove(NodeID{i});
+            }
+            return merged_;
+        }
+
+        // as above, then drops whatever the (pre-merge) `roots` no longer depend on, e.g. the
+        // subtrees ConstantFolding left behind. input nodes stay, see Graph::remove
+        std::size_t run(Graph<T>& G, std::span<const NodeID> roots) {
+            run(G);
+            std::vector<NodeID> kept;
+            kept.reserve(roots.size());
+            for (auto root : roots) kept.push_back(canonical(root));
+            removed_ += G.remove_unreferenced(kept);
+            return merged_;
+        }
+
+        // the node that now stands for `id`, itself if it wasn't merged
+        NodeID canonical(NodeID id) const {
+            return id.index() < canonical_.size() ? canonical_[id.index()] : id;
+        }
+
+        std::size_t merged() const noexcept { return merged_; }
+
+        // merged nodes plus anything their removal or the roots sweep took along
+        std::size_t removed() const noexcept { return removed_; }
+
+    private:
+        std::vector<NodeID> canonical_; // by index, from the last run
+        std::size_t merged_ = 0;
+        std::size_t removed_ = 0;
+    };
+
+} // namespace cg::opt
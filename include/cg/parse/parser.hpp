@@ -0,0 +1,269 @@
+#pragma once
+#include "../graph.hpp"
+#include "../ops.hpp"
+
+#include <cctype>
+#include <charconv>
+#include <functional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace cg::parse {
+
+    // infix formulas straight into a Graph<T>:
+    //
+    //   expr    := term (('+' | '-') term)*
+    //   term    := unary (('*' | '/') unary)*
+    //   unary   := '-' unary | power
+    //   power   := primary ('^' unary)?          right associative, -x^2 is -(x^2)
+    //   primary := number | name | name '(' expr (',' expr)* ')' | '(' expr ')'
+    //
+    // functions are the ones of ops.hpp: sin, cos, exp, log, sqrt and pow(base, exponent).
+    // any other name is an input. nodes go through Graph::emplace, so repeated subexpressions
+    // are shared (also across formulas parsed into the same graph) and tokens never hit the heap:
+    // the lexer hands out views into the source text and input names are looked up without copying
+    template<Numeric T>
+    class Parser {
+    public:
+        explicit Parser(Graph<T>& G) : G_(&G) {}
+
+        NodeID parse(std::string_view text) {
+            src_ = text;
+            pos_ = 0;
+            depth_ = 0;
+            next();
+            NodeID root = expr();
+            if (tok_.kind != Tok::end) fail("unexpected " + describe(tok_));
+            return root;
+        }
+
+        // parses every formula into the shared graph, out[i] receives the root of formulas[i]
+        void parse_all(std::span<const std::string_view> formulas, std::span<NodeID> out) {
+            if (out.size() < formulas.size()) {
+                throw std::runtime_error("expected room for " + std::to_string(formulas.size()) + " roots, got " +
+                                         std::to_string(out.size()));
+            }
+            for (std::size_t i = 0; i < formulas.size(); ++i) {
+                out[i] = parse(formulas[i]);
+            }
+        }
+
+        // tokens consumed over the parser's lifetime
+        std::size_t tokens() const noexcept { return tokens_; }
+
+        static constexpr std::size_t max_depth = 256;
+
+    private:
+        enum class Tok { end, number, name, plus, minus, star, slash, caret, lparen, rparen, comma };
+
+        struct Token {
+            Tok kind = Tok::end;
+            std::string_view text;
+            std::size_t pos = 0;
+            double number = 0.0;
+        };
+
+        // ------------- lexer -------------
+
+        void next() {
+            while (pos_ < src_.size() && std::isspace(static_cast<unsigned char>(src_[pos_]))) ++pos_;
+            tok_ = Token{Tok::end, {}, pos_};
+            if (pos_ == src_.size()) return;
+            ++tokens_;
+
+            const char c = src_[pos_];
+            if (std::isdigit(static_cast<unsigned char>(c)) || c == '.') {
+                auto [end, ec] = std::from_chars(src_.data() + pos_, src_.data() + src_.size(), tok_.number);
+                if (ec != std::errc{}) fail("malformed number");
+                const std::size_t len = static_cast<std::size_t>(end - (src_.data() + pos_));
+                tok_.kind = Tok::number;
+                tok_.text = src_.substr(pos_, len);
+                pos_ += len;
+                return;
+            }
+            if (std::isalpha(static_cast<unsigned char>(c)) || c == '_') {
+                std::size_t end = pos_ + 1;
+                while (end < src_.size() && (std::isalnum(static_cast<unsigned char>(src_[end])) || src_[end] == '_')) ++end;
+                tok_.kind = Tok::name;
+                tok_.text = src_.substr(pos_, end - pos_);
+                pos_ = end;
+                return;
+            }
+
+            switch (c) {
+                case '+': tok_.kind = Tok::plus; break;
+                case '-': tok_.kind = Tok::minus; break;
+                case '*': tok_.kind = Tok::star; break;
+                case '/': tok_.kind = Tok::slash; break;
+                case '^': tok_.kind = Tok::caret; break;
+                case '(': tok_.kind = Tok::lparen; break;
+                case ')': tok_.kind = Tok::rparen; break;
+                case ',': tok_.kind = Tok::comma; break;
+                default: fail(std::string("unexpected character '") + c + "'");
+            }
+            tok_.text = src_.substr(pos_, 1);
+            ++pos_;
+        }
+
+        void expect(Tok kind, const char* what) {
+            if (tok_.kind != kind) fail(std::string("expected ") + what + ", got " + describe(tok_));
+            next();
+        }
+
+        // ------------- grammar -------------
+
+        NodeID expr() {
+            NodeID lhs = term();
+            while (tok_.kind == Tok::plus || tok_.kind == Tok::minus) {
+                const bool add = tok_.kind == Tok::plus;
+                next();
+                NodeID rhs = term();
+                lhs = add ? binary<ops::Add>(lhs, rhs) : binary<ops::Sub>(lhs, rhs);
+            }
+            return lhs;
+        }
+
+        NodeID term() {
+            NodeID lhs = unary();
+            while (tok_.kind == Tok::star || tok_.kind == Tok::slash) {
+                const bool mul = tok_.kind == Tok::star;
+                next();
+                NodeID rhs = unary();
+                lhs = mul ? binary<ops::Mul>(lhs, rhs) : binary<ops::Div>(lhs, rhs);
+            }
+            return lhs;
+        }
+
+        NodeID unary() {
+            if (tok_.kind == Tok::minus) {
+                Nest guard(*this);
+                next();
+                return unary_op<ops::Neg>(unary());
+            }
+            return power();
+        }
+
+        NodeID power() {
+            NodeID base = primary();
+            if (tok_.kind == Tok::caret) {
+                Nest guard(*this);
+                next();
+                return binary<ops::Pow>(base, unary());
+            }
+            return base;
+        }
+
+        NodeID primary() {
+            if (tok_.kind == Tok::number) {
+                const double v = tok_.number;
+                next();
+                return G_->template emplace<ConstantNode<T>>(T(v));
+            }
+            if (tok_.kind == Tok::lparen) {
+                Nest guard(*this);
+                next();
+                NodeID inner = expr();
+                expect(Tok::rparen, "')'");
+                return inner;
+            }
+            if (tok_.kind == Tok::name) {
+                const Token name = tok_;
+                next();
+                if (tok_.kind == Tok::lparen) return function(name);
+                return input(name.text);
+            }
+            fail("expected a number, a name or '(', got " + describe(tok_));
+        }
+
+        NodeID function(const Token& name) {
+            Nest guard(*this);
+            next(); // '('
+            NodeID a = expr();
+            if (name.text == "pow") {
+                expect(Tok::comma, "','");
+                NodeID b = expr();
+                expect(Tok::rparen, "')'");
+                return binary<ops::Pow>(a, b);
+            }
+            expect(Tok::rparen, "')'");
+
+            if (name.text == "sin") return unary_op<ops::Sin>(a);
+            if (name.text == "cos") return unary_op<ops::Cos>(a);
+            if (name.text == "exp") return unary_op<ops::Exp>(a);
+            if (name.text == "log") return unary_op<ops::Log>(a);
+            if (name.text == "sqrt") return unary_op<ops::Sqrt>(a);
+            fail_at(name.pos, "unknown function '" + std::string(name.text) + "'");
+        }
+
+        // ------------- graph -------------
+
+        // the graph may have dropped a cached input since (an explicit remove, a pass),
+        // then it gets a fresh node and the cache follows
+        NodeID input(std::string_view name) {
+            auto it = inputs_.find(name);
+            if (it != inputs_.end() && G_->alive(it->second)) return it->second;
+            NodeID id = G_->input(std::string(name));
+            if (it != inputs_.end()) {
+                it->second = id;
+            } else {
+                inputs_.emplace(std::string(name), id);
+            }
+            return id;
+        }
+
+        template<typename O>
+        NodeID unary_op(NodeID a) {
+            return G_->template emplace<UnaryNode<T, O>>(a);
+        }
+
+        template<typename O>
+        NodeID binary(NodeID a, NodeID b) {
+            return G_->template emplace<BinaryNode<T, O>>(a, b);
+        }
+
+        // ------------- errors -------------
+
+        // bounds recursion so hostile input can't blow the stack
+        struct Nest {
+            explicit Nest(Parser& p) : p_(p) {
+                if (++p_.depth_ > max_depth) p_.fail("formula nests deeper than " + std::to_string(max_depth) + " levels");
+            }
+            ~Nest() { --p_.depth_; }
+            Parser& p_;
+        };
+
+        static std::string describe(const Token& t) {
+            return t.kind == Tok::end ? std::string("end of input") : "'" + std::string(t.text) + "'";
+        }
+
+        [[noreturn]] void fail_at(std::size_t pos, const std::string& what) const {
+            throw std::runtime_error("parse error at position " + std::to_string(pos) + ": " + what);
+        }
+
+        [[noreturn]] void fail(const std::string& what) const { fail_at(tok_.pos, what); }
+
+        struct NameHash {
+            using is_transparent = void;
+            std::size_t operator()(std::string_view s) const noexcept { return std::hash<std::string_view>{}(s); }
+        };
+
+        Graph<T>* G_;
+        std::unordered_map<std::string, NodeID, NameHash, std::equal_to<>> inputs_;
+
+        std::string_view src_;
+        std::size_t pos_ = 0;
+        std::size_t depth_ = 0;
+        std::size_t tokens_ = 0;
+        Token tok_;
+    };
+
+    // one-off convenience, for many formulas keep a Parser around so input names stay cached
+    template<Numeric T>
+    NodeID parse(Graph<T>& G, std::string_view text) {
+        return Parser<T>(G).parse(text);
+    }
+
+} // namespace cg::parse
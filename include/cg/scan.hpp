@@ -0,0 +1,250 @@
+#pragma once
+#include "function.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <memory>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+namespace cg {
+
+    enum class ScanOutput { final_state, all_states };
+
+    // s[t] = step(s[t - 1], xs[t], invariants...) for t = 0 .. xs.size() - 1, starting from s[-1] = init.
+    // step's parameters are, in order, the carried state, the sequence element and the loop invariants.
+    // runs the step's compiled body once per element, so it takes constant graph size and linear time.
+    // returns every state s[0..] or just the last one (init for an empty sequence)
+    template<Numeric T>
+    std::vector<T> run_scan(const Function<T>& step, T init, std::span<const T> xs,
+                            std::span<const T> invariants = {}, ScanOutput output = ScanOutput::final_state) {
+        if (step.arity() != 2 + invariants.size()) {
+            throw std::runtime_error("scan step " + step.name() + " takes " + std::to_string(step.arity()) +
+                                     " parameters, expected state, element and " +
+                                     std::to_string(invariants.size()) + " invariants");
+        }
+
+        std::vector<T> states;
+        if (output == ScanOutput::all_states) states.reserve(xs.size());
+
+        T s = init;
+        for (const T& x : xs) {
+            s = step.invoke([&](std::size_t p) -> T {
+                if (p == 0) return s;
+                if (p == 1) return x;
+                return invariants[p - 2];
+            }, 0);
+            if (output == ScanOutput::all_states) states.push_back(s);
+        }
+        if (output == ScanOutput::final_state) states.push_back(s);
+        return states;
+    }
+
+    // one state of a scan over a sequence bound to the node: the final one, or with `at` set the
+    // state after element `at`, see scan_states(). the initial state and the loop invariants are
+    // graph nodes, so derivatives flow through them when T is a Dual.
+    // batches run the step's body over all rows in lockstep, one element at a time.
+    // per-step nodes of the same scan share one run: the states of the last one are kept per thread,
+    // keyed on identical() inputs so an init of -0.0 never picks up the states of +0.0
+    template<Numeric T>
+    class ScanNode final : public Node<T> {
+    public:
+        static constexpr std::size_t final_state = std::numeric_limits<std::size_t>::max();
+
+        ScanNode(std::shared_ptr<const Function<T>> step, NodeID init, std::vector<NodeID> invariants,
+                 std::shared_ptr<const std::vector<T>> sequence, std::size_t at = final_state)
+            : step_(std::move(step)), sequence_(std::move(sequence)), at_(at) {
+            if (step_->arity() != 2 + invariants.size()) {
+                throw std::runtime_error("scan step " + step_->name() + " takes " + std::to_string(step_->arity()) +
+                                         " parameters, expected state, element and " +
+                                         std::to_string(invariants.size()) + " invariants");
+            }
+            if (at_ != final_state && at_ >= sequence_->size()) {
+                throw std::runtime_error("scan over " + std::to_string(sequence_->size()) + " elements has no state " +
+                                         std::to_string(at_));
+            }
+            ins_.push_back(init);
+            ins_.insert(ins_.end(), invariants.begin(), invariants.end());
+        }
+
+        std::string_view kind() const noexcept override { return "scan"; }
+
+        // the initial state first, then the invariants
+        std::span<const NodeID> inputs() const noexcept override { return ins_; }
+
+        T evaluate_from_cache(std::span<const T> values) const override {
+            T out{};
+            evaluate_rows([&](std::size_t i) { return &values[ins_[i].index()]; }, std::span<T>(&out, 1));
+            return out;
+        }
+
+        void evaluate_batch(std::span<const T* const> columns, std::span<T> out) const override {
+            evaluate_rows([&](std::size_t i) { return columns[ins_[i].index()]; }, out);
+        }
+
+        // same step + same sequence + same inputs + same state = same node
+        std::size_t hash() const noexcept override {
+            std::size_t h = std::hash<const void*>{}(step_.get());
+            hash_combine(h, std::hash<const void*>{}(sequence_.get()));
+            for (auto in : ins_) hash_combine(h, in.index());
+            hash_combine(h, at_);
+            return h;
+        }
+
+        bool is_equivalent(const Node<T>& other) const noexcept override {
+            if (auto* s = dynamic_cast<const ScanNode*>(&other)) {
+                return step_ == s->step_ && sequence_ == s->sequence_ && ins_ == s->ins_ && at_ == s->at_;
+            }
+            return false;
+        }
+
+        std::string label() const noexcept override {
+            return "scan " + step_->name() + (at_ == final_state ? "" : "[" + std::to_string(at_) + "]");
+        }
+
+        // the sequence and the step body are shared between nodes
+        std::size_t footprint() const noexcept override {
+            return sizeof(*this) + ins_.capacity() * sizeof(NodeID);
+        }
+
+        std::unique_ptr<Node<T>> with_inputs(std::span<const NodeID> inputs) const override {
+            return std::make_unique<ScanNode>(step_, inputs[0],
+                                              std::vector<NodeID>(inputs.begin() + 1, inputs.end()), sequence_, at_);
+        }
+
+        const std::shared_ptr<const Function<T>>& step() const noexcept { return step_; }
+        const std::shared_ptr<const std::vector<T>>& sequence() const noexcept { return sequence_; }
+        std::size_t at() const noexcept { return at_; }
+
+    private:
+        // the states of the last per-step run on this thread, element-major with `rows` values each.
+        // the step and the sequence are only watched: a pool worker must not keep them alive once
+        // the graph is gone. an expired control block can't be handed to a new object, so matching
+        // on ownership rather than addresses never confuses a dead scan with a new one
+        struct Memo {
+            std::weak_ptr<const Function<T>> step;
+            std::weak_ptr<const std::vector<T>> sequence;
+            std::size_t rows = 0;
+            std::vector<T> inputs; // input-major
+            std::vector<T> states;
+        };
+
+        static Memo& last_run() {
+            thread_local Memo memo;
+            return memo;
+        }
+
+        // in(i) points at the rows of input i
+        template<typename In>
+        void evaluate_rows(In&& in, std::span<T> out) const {
+            const std::size_t rows = out.size();
+            if (at_ == final_state) {
+                run(in, rows, sequence_->size(), out.data(), nullptr);
+                return;
+            }
+            if constexpr (Identifiable<T>) {
+                auto& memo = last_run();
+                if (!remembered(memo, in, rows)) {
+                    // nested scans in the step use the memo too. the states buffer is taken out while
+                    // running, so they start one of their own rather than writing into this one
+                    std::vector<T> states = std::move(memo.states);
+                    memo.step.reset();
+                    memo.sequence.reset();
+                    states.resize(sequence_->size() * rows);
+                    run(in, rows, sequence_->size(), nullptr, states.data());
+                    memo.step = step_;
+                    memo.sequence = sequence_;
+                    memo.rows = rows;
+                    memo.inputs.resize(ins_.size() * rows);
+                    for (std::size_t i = 0; i < ins_.size(); ++i) std::copy_n(in(i), rows, memo.inputs.data() + i * rows);
+                    memo.states = std::move(states);
+                }
+                std::copy_n(memo.states.data() + at_ * rows, rows, out.data());
+            } else {
+                run(in, rows, at_ + 1, out.data(), nullptr);
+            }
+        }
+
+        template<typename In>
+        bool remembered(const Memo& memo, In&& in, std::size_t rows) const {
+            if (!owned_by(memo.step, step_) || !owned_by(memo.sequence, sequence_) || memo.rows != rows) return false;
+            for (std::size_t i = 0; i < ins_.size(); ++i) {
+                const T* column = in(i);
+                for (std::size_t r = 0; r < rows; ++r) {
+                    if (!identical(memo.inputs[i * rows + r], column[r])) return false;
+                }
+            }
+            return true;
+        }
+
+        template<typename U>
+        static bool owned_by(const std::weak_ptr<U>& watched, const std::shared_ptr<U>& p) noexcept {
+            return !watched.owner_before(p) && !p.owner_before(watched);
+        }
+
+        // the first `steps` elements over `rows` rows in lockstep, the last state goes to `out` when
+        // it is set and every state to states[t * rows] when that is
+        template<typename In>
+        void run(In&& in, std::size_t rows, std::size_t steps, T* out, T* states) const {
+            auto frame = eval::Scratch<T>::acquire(3 * rows);
+            T* state = frame.values().data();
+            T* next = state + rows;
+            T* element = next + rows;
+            std::copy_n(in(0), rows, state);
+            for (std::size_t t = 0; t < steps; ++t) {
+                std::fill_n(element, rows, (*sequence_)[t]);
+                step_->invoke_batch([&](std::size_t p) -> const T* {
+                    if (p == 0) return state;
+                    if (p == 1) return element;
+                    return in(p - 1);
+                }, rows, 0, next);
+                std::swap(state, next);
+                if (states) std::copy_n(state, rows, states + t * rows);
+            }
+            if (out) std::copy_n(state, rows, out);
+        }
+
+        std::shared_ptr<const Function<T>> step_;
+        std::shared_ptr<const std::vector<T>> sequence_;
+        std::vector<NodeID> ins_;
+        std::size_t at_;
+    };
+
+    template<Numeric T>
+    Expression<T> scan(const std::shared_ptr<const Function<T>>& step, Expression<T> init,
+                       std::type_identity_t<std::shared_ptr<const std::vector<T>>> sequence,
+                       const std::vector<Expression<T>>& invariants = {}) {
+        auto& G = init.graph();
+        std::vector<NodeID> ids;
+        for (const auto& inv : invariants) {
+            assert(&inv.graph() == &G && "cannot combine expressions from different graphs :(");
+            ids.push_back(inv.root());
+        }
+        return Expression<T>(&G, G.add(std::make_unique<ScanNode<T>>(step, init.root(), std::move(ids),
+                                                                      std::move(sequence))));
+    }
+
+    // ScanOutput::all_states inside a graph: one node per element, node t is the state after it.
+    // the nodes share a single run of the scan per evaluation (per block of rows in batches).
+    // that takes a value type identical() works on: without it every node reruns the scan up to its
+    // own element, which is quadratic in the sequence length
+    template<Numeric T>
+    std::vector<Expression<T>> scan_states(const std::shared_ptr<const Function<T>>& step, Expression<T> init,
+                                           std::type_identity_t<std::shared_ptr<const std::vector<T>>> sequence,
+                                           const std::vector<Expression<T>>& invariants = {}) {
+        auto& G = init.graph();
+        std::vector<NodeID> ids;
+        for (const auto& inv : invariants) {
+            assert(&inv.graph() == &G && "cannot combine expressions from different graphs :(");
+            ids.push_back(inv.root());
+        }
+        std::vector<Expression<T>> states;
+        states.reserve(sequence->size());
+        for (std::size_t t = 0; t < sequence->size(); ++t) {
+            states.emplace_back(&G, G.add(std::make_unique<ScanNode<T>>(step, init.root(), ids, sequence, t)));
+        }
+        return states;
+    }
+
+} // namespace cg
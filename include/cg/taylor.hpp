@@ -0,0 +1,259 @@
+#pragma once
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+#include "identical.hpp"
+
+namespace cg {
+
+    // truncated taylor series in one direction: c[k] holds f^(k)(x) / k! for k < K.
+    // every op propagates all K coefficients with the usual power series recurrences,
+    // so a node costs O(K^2) no matter how high the order, unlike nesting Duals which doubles per order
+    template<typename T, std::size_t K>
+    struct Taylor {
+        static_assert(K >= 1, "a taylor series needs at least the value coefficient");
+
+        std::array<T, K> c{}; // contiguous, the recurrences below run over it in plain loops
+
+        Taylor(T v = 0) { c[0] = v; }
+
+        // the independent variable x0 + t * direction
+        static Taylor variable(T x0, T direction = T(1)) {
+            Taylor x(x0);
+            if constexpr (K > 1) x.c[1] = direction;
+            return x;
+        }
+
+        T value() const noexcept { return c[0]; }
+
+        // k-th derivative along the seeded direction, only the first K are carried
+        T derivative(std::size_t k) const {
+            if (k >= K) {
+                throw std::runtime_error("derivative " + std::to_string(k) + " of a series truncated at " + std::to_string(K));
+            }
+            T f = c[k];
+            for (std::size_t i = 2; i <= k; ++i) f = f * T(i);
+            return f;
+        }
+
+        Taylor operator+(const Taylor& x) const {
+            Taylor r;
+            for (std::size_t k = 0; k < K; ++k) r.c[k] = c[k] + x.c[k];
+            return r;
+        }
+
+        Taylor operator-(const Taylor& x) const {
+            Taylor r;
+            for (std::size_t k = 0; k < K; ++k) r.c[k] = c[k] - x.c[k];
+            return r;
+        }
+
+        // cauchy product
+        Taylor operator*(const Taylor& x) const {
+            Taylor r;
+            for (std::size_t k = 0; k < K; ++k) {
+                T s = 0;
+                for (std::size_t j = 0; j <= k; ++j) s = s + c[j] * x.c[k - j];
+                r.c[k] = s;
+            }
+            return r;
+        }
+
+        // q = a / b  =>  q_k = (a_k - sum_{j=1..k} b_j q_{k-j}) / b_0
+        Taylor operator/(const Taylor& x) const {
+            Taylor q;
+            for (std::size_t k = 0; k < K; ++k) {
+                T s = c[k];
+                for (std::size_t j = 1; j <= k; ++j) s = s - x.c[j] * q.c[k - j];
+                q.c[k] = s / x.c[0];
+            }
+            return q;
+        }
+
+        Taylor operator-() const {
+            Taylor r;
+            for (std::size_t k = 0; k < K; ++k) r.c[k] = -c[k];
+            return r;
+        }
+
+        bool operator==(const Taylor&) const = default;
+
+        // true when only the value coefficient is set, i.e. the series doesn't vary along t
+        bool is_constant() const noexcept {
+            for (std::size_t k = 1; k < K; ++k) {
+                if (c[k] != T(0)) return false;
+            }
+            return true;
+        }
+    };
+
+    template<typename T, std::size_t K> Taylor<T, K> operator+(T a, const Taylor<T, K>& x) { return Taylor<T, K>(a) + x; }
+    template<typename T, std::size_t K> Taylor<T, K> operator+(const Taylor<T, K>& x, T a) { return x + Taylor<T, K>(a); }
+    template<typename T, std::size_t K> Taylor<T, K> operator-(T a, const Taylor<T, K>& x) { return Taylor<T, K>(a) - x; }
+    template<typename T, std::size_t K> Taylor<T, K> operator-(const Taylor<T, K>& x, T a) { return x - Taylor<T, K>(a); }
+    template<typename T, std::size_t K> Taylor<T, K> operator*(T a, const Taylor<T, K>& x) {
+        Taylor<T, K> r;
+        for (std::size_t k = 0; k < K; ++k) r.c[k] = a * x.c[k];
+        return r;
+    }
+    template<typename T, std::size_t K> Taylor<T, K> operator*(const Taylor<T, K>& x, T a) { return a * x; }
+
+    template<typename T, std::size_t K>
+    bool identical(const Taylor<T, K>& a, const Taylor<T, K>& b) {
+        for (std::size_t k = 0; k < K; ++k) {
+            if (!identical(a.c[k], b.c[k])) return false;
+        }
+        return true;
+    }
+
+    template<typename T, std::size_t K>
+    std::ostream& operator<<(std::ostream& os, const Taylor<T, K>& x) {
+        os << "{";
+        for (std::size_t k = 0; k < K; ++k) os << (k ? ", " : "") << x.c[k];
+        return os << "}";
+    }
+
+    // e = exp(a)  =>  e_k = 1/k sum_{j=1..k} j a_j e_{k-j}
+    template<typename T, std::size_t K> Taylor<T, K> exp(const Taylor<T, K>& a) {
+        using std::exp;
+        Taylor<T, K> e(exp(a.c[0]));
+        for (std::size_t k = 1; k < K; ++k) {
+            T s = 0;
+            for (std::size_t j = 1; j <= k; ++j) s = s + T(j) * a.c[j] * e.c[k - j];
+            e.c[k] = s / T(k);
+        }
+        return e;
+    }
+
+    // l = log(a)  =>  l_k = (a_k - 1/k sum_{j=1..k-1} j l_j a_{k-j}) / a_0
+    template<typename T, std::size_t K> Taylor<T, K> log(const Taylor<T, K>& a) {
+        using std::log;
+        Taylor<T, K> l(log(a.c[0]));
+        for (std::size_t k = 1; k < K; ++k) {
+            T s = 0;
+            for (std::size_t j = 1; j < k; ++j) s = s + T(j) * l.c[j] * a.c[k - j];
+            l.c[k] = (a.c[k] - s / T(k)) / a.c[0];
+        }
+        return l;
+    }
+
+    // r = sqrt(a)  =>  r_k = (a_k - sum_{j=1..k-1} r_j r_{k-j}) / 2 r_0
+    template<typename T, std::size_t K> Taylor<T, K> sqrt(const Taylor<T, K>& a) {
+        using std::sqrt;
+        Taylor<T, K> r(sqrt(a.c[0]));
+        for (std::size_t k = 1; k < K; ++k) {
+            T s = a.c[k];
+            for (std::size_t j = 1; j < k; ++j) s = s - r.c[j] * r.c[k - j];
+            r.c[k] = s / (T(2) * r.c[0]);
+        }
+        return r;
+    }
+
+    // sine and cosine feed each other:
+    // s_k = 1/k sum_{j=1..k} j a_j c_{k-j},  c_k = -1/k sum_{j=1..k} j a_j s_{k-j}
+    template<typename T, std::size_t K>
+    void sincos(const Taylor<T, K>& a, Taylor<T, K>& s, Taylor<T, K>& co) {
+        using std::sin, std::cos;
+        s = Taylor<T, K>(sin(a.c[0]));
+        co = Taylor<T, K>(cos(a.c[0]));
+        for (std::size_t k = 1; k < K; ++k) {
+            T ss = 0, cc = 0;
+            for (std::size_t j = 1; j <= k; ++j) {
+                ss = ss + T(j) * a.c[j] * co.c[k - j];
+                cc = cc + T(j) * a.c[j] * s.c[k - j];
+            }
+            s.c[k] = ss / T(k);
+            co.c[k] = -cc / T(k);
+        }
+    }
+
+    template<typename T, std::size_t K> Taylor<T, K> sin(const Taylor<T, K>& a) {
+        Taylor<T, K> s, co;
+        sincos(a, s, co);
+        return s;
+    }
+
+    template<typename T, std::size_t K> Taylor<T, K> cos(const Taylor<T, K>& a) {
+        Taylor<T, K> s, co;
+        sincos(a, s, co);
+        return co;
+    }
+
+    // p = u^r for a constant r and u_0 != 0, first n coefficients:
+    // p_k = 1/(k u_0) sum_{j=1..k} ((r + 1) j - k) u_j p_{k-j}, which also works for negative bases
+    template<typename T> void pow_series(const T* u, std::size_t n, T r, T* p) {
+        using std::pow;
+        p[0] = pow(u[0], r);
+        for (std::size_t k = 1; k < n; ++k) {
+            T s = 0;
+            for (std::size_t j = 1; j <= k; ++j) s = s + ((r + T(1)) * T(j) - T(k)) * u[j] * p[k - j];
+            p[k] = s / (T(k) * u[0]);
+        }
+    }
+
+    // a constant r at a zero base, where the recurrence would divide by a_0.
+    // whole powers are plain products. otherwise write a = t^m u with u_0 = a_m != 0, so a^r = t^(m r) u^r:
+    // coefficients below m r vanish and the ones past it diverge, unless m r is whole, then u^r is
+    // shifted in (nan where that needs terms of a beyond the truncation)
+    template<typename T, std::size_t K> Taylor<T, K> pow_zero_base(const Taylor<T, K>& a, T r) {
+        using std::pow, std::floor;
+        if (r >= T(0) && r == floor(r)) {
+            // a^K and up vanish to the order we carry
+            Taylor<T, K> p(T(1));
+            for (std::size_t n = 0; T(n) < r && n < K; ++n) p = p * a;
+            return p;
+        }
+        std::size_t m = 1;
+        while (m < K && a.c[m] == T(0)) ++m;
+        const T e = T(m) * r;
+        const T unknown = std::numeric_limits<T>::quiet_NaN();
+
+        Taylor<T, K> p(pow(a.c[0], r)); // 0 for r > 0, inf below
+        if (m == K) {
+            for (std::size_t k = 1; k < K; ++k) p.c[k] = T(k) < e ? T(0) : unknown;
+            return p;
+        }
+        if (e < T(0) || e != floor(e)) {
+            // the sign t^e picks up from u, nan when u_0 < 0 has no real r-th power
+            const T lead = pow(a.c[m], r) * std::numeric_limits<T>::infinity();
+            for (std::size_t k = 1; k < K; ++k) p.c[k] = T(k) < e ? T(0) : lead;
+            return p;
+        }
+        const auto shift = static_cast<std::size_t>(e);
+        std::array<T, K> u{}, q{};
+        for (std::size_t i = 0; i + m < K; ++i) u[i] = a.c[i + m];
+        pow_series(u.data(), K - m, r, q.data());
+        for (std::size_t k = 1; k < K; ++k) {
+            p.c[k] = k < shift ? T(0) : k - shift < K - m ? q[k - shift] : unknown;
+        }
+        return p;
+    }
+
+    // a constant exponent has its own recurrence, see pow_series. a varying exponent goes through exp(b log a)
+    template<typename T, std::size_t K> Taylor<T, K> pow(const Taylor<T, K>& a, const Taylor<T, K>& b) {
+        if (!b.is_constant()) return exp(b * log(a));
+        if (a.c[0] == T(0)) return pow_zero_base(a, b.c[0]);
+        Taylor<T, K> p;
+        pow_series(a.c.data(), K, b.c[0], p.c.data());
+        return p;
+    }
+
+} // namespace cg
+
+// lets Taylor constants take part in cse (ConstantNode hashes its value)
+template<typename T, std::size_t K>
+struct std::hash<cg::Taylor<T, K>> {
+    std::size_t operator()(const cg::Taylor<T, K>& x) const noexcept {
+        std::size_t seed = 0;
+        for (const auto& v : x.c) {
+            seed ^= std::hash<T>{}(v) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+        }
+        return seed;
+    }
+};
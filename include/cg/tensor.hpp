@@ -0,0 +1,235 @@
+#pragma once
+#include "expression.hpp"
+#include "identical.hpp"
+#include "ops.hpp"
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <functional>
+#include <initializer_list>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace cg {
+
+    // a dense row-major matrix value, vectors are n x 1 or 1 x n and scalars 1 x 1.
+    // the arithmetic operators return fresh tensors (Numeric asks for them), the graph itself
+    // evaluates through the apply_into overloads below, which resize the output in place: once
+    // every value slot has grown to its shape, evaluation stops allocating
+    template<typename S>
+    class Tensor {
+    public:
+        using Shape = std::array<std::size_t, 2>;
+
+        Tensor() = default; // 0 x 0, owns nothing
+        Tensor(S value) : rows_(1), cols_(1), data_(1, value) {}
+        Tensor(std::size_t rows, std::size_t cols, S fill = S(0)) : rows_(rows), cols_(cols), data_(rows * cols, fill) {}
+
+        Tensor(std::size_t rows, std::size_t cols, std::initializer_list<S> values)
+            : rows_(rows), cols_(cols), data_(values) {
+            if (data_.size() != rows * cols) {
+                throw std::runtime_error("a " + std::to_string(rows) + "x" + std::to_string(cols) + " tensor needs " +
+                                         std::to_string(rows * cols) + " values, got " + std::to_string(data_.size()));
+            }
+        }
+
+        // n x 1
+        static Tensor column(std::initializer_list<S> values) { return Tensor(values.size(), 1, values); }
+
+        std::size_t rows() const noexcept { return rows_; }
+        std::size_t cols() const noexcept { return cols_; }
+        std::size_t size() const noexcept { return data_.size(); }
+        Shape shape() const noexcept { return {rows_, cols_}; }
+
+        S& operator[](std::size_t i) noexcept { return data_[i]; }
+        const S& operator[](std::size_t i) const noexcept { return data_[i]; }
+        S& operator()(std::size_t r, std::size_t c) noexcept { return data_[r * cols_ + c]; }
+        const S& operator()(std::size_t r, std::size_t c) const noexcept { return data_[r * cols_ + c]; }
+
+        S* data() noexcept { return data_.data(); }
+        const S* data() const noexcept { return data_.data(); }
+
+        // new shape, contents unspecified. only allocates when the storage has to grow
+        void resize(std::size_t rows, std::size_t cols) {
+            rows_ = rows;
+            cols_ = cols;
+            data_.resize(rows * cols);
+        }
+
+        std::size_t capacity() const noexcept { return data_.capacity(); }
+
+        bool operator==(const Tensor&) const = default;
+
+    private:
+        std::size_t rows_ = 0, cols_ = 0;
+        std::vector<S> data_;
+    };
+
+    namespace detail {
+
+        // numpy style along `axis` (0 rows, 1 cols): equal extents, or one of them is 1
+        inline std::size_t broadcast(std::array<std::size_t, 2> x, std::array<std::size_t, 2> y, std::size_t axis) {
+            const std::size_t a = x[axis], b = y[axis];
+            if (a == b || b == 1) return a;
+            if (a == 1) return b;
+            throw std::runtime_error("cannot broadcast a " + std::to_string(x[0]) + "x" + std::to_string(x[1]) +
+                                     " tensor against a " + std::to_string(y[0]) + "x" + std::to_string(y[1]) + " one");
+        }
+
+    } // namespace detail
+
+    // element-wise kernels, any scalar functor of ops.hpp works. `out` must not alias an operand
+
+    template<typename O, typename S>
+    void apply_into(const O& o, const Tensor<S>& x, Tensor<S>& out) {
+        out.resize(x.rows(), x.cols());
+        for (std::size_t i = 0; i < x.size(); ++i) out[i] = o(x[i]);
+    }
+
+    template<typename O, typename S>
+    void apply_into(const O& o, const Tensor<S>& x, const Tensor<S>& y, Tensor<S>& out) {
+        const std::size_t rows = detail::broadcast(x.shape(), y.shape(), 0);
+        const std::size_t cols = detail::broadcast(x.shape(), y.shape(), 1);
+        out.resize(rows, cols);
+        const std::size_t n = out.size();
+
+        if (x.shape() == y.shape()) {
+            for (std::size_t i = 0; i < n; ++i) out[i] = o(x[i], y[i]);
+        } else if (y.size() == 1) {
+            const S b = y[0];
+            for (std::size_t i = 0; i < n; ++i) out[i] = o(x[i], b);
+        } else if (x.size() == 1) {
+            const S a = x[0];
+            for (std::size_t i = 0; i < n; ++i) out[i] = o(a, y[i]);
+        } else {
+            // a broadcast extent steps by 0
+            const std::size_t xr = x.rows() == 1 ? 0 : x.cols(), xc = x.cols() == 1 ? 0 : 1;
+            const std::size_t yr = y.rows() == 1 ? 0 : y.cols(), yc = y.cols() == 1 ? 0 : 1;
+            for (std::size_t r = 0; r < rows; ++r) {
+                for (std::size_t c = 0; c < cols; ++c) {
+                    out(r, c) = o(x[r * xr + c * xc], y[r * yr + c * yc]);
+                }
+            }
+        }
+    }
+
+} // namespace cg
+
+namespace cg::ops {
+
+    struct MatMul {
+        static constexpr auto symbol = "matmul";
+
+        template<typename S>
+        Tensor<S> operator()(const Tensor<S>& a, const Tensor<S>& b) const {
+            Tensor<S> out;
+            apply_into(*this, a, b, out);
+            return out;
+        }
+    };
+
+    // sum of every element, as a 1 x 1 tensor
+    struct Sum {
+        static constexpr auto symbol = "sum";
+
+        template<typename S>
+        Tensor<S> operator()(const Tensor<S>& a) const {
+            Tensor<S> out;
+            apply_into(*this, a, out);
+            return out;
+        }
+    };
+
+} // namespace cg::ops
+
+namespace cg {
+
+    template<typename S>
+    void apply_into(const ops::MatMul&, const Tensor<S>& a, const Tensor<S>& b, Tensor<S>& out) {
+        if (a.cols() != b.rows()) {
+            throw std::runtime_error("matmul of a " + std::to_string(a.rows()) + "x" + std::to_string(a.cols()) +
+                                     " and a " + std::to_string(b.rows()) + "x" + std::to_string(b.cols()) + " tensor");
+        }
+        out.resize(a.rows(), b.cols());
+        std::fill(out.data(), out.data() + out.size(), S(0));
+        // i-k-j so the inner loop runs along rows of b and out
+        for (std::size_t i = 0; i < a.rows(); ++i) {
+            for (std::size_t k = 0; k < a.cols(); ++k) {
+                const S aik = a(i, k);
+                for (std::size_t j = 0; j < b.cols(); ++j) out(i, j) += aik * b(k, j);
+            }
+        }
+    }
+
+    template<typename S>
+    void apply_into(const ops::Sum&, const Tensor<S>& a, Tensor<S>& out) {
+        S total = S(0);
+        for (std::size_t i = 0; i < a.size(); ++i) total += a[i];
+        out.resize(1, 1);
+        out[0] = total;
+    }
+
+    // by-value arithmetic, allocates a fresh result every time
+
+    template<typename S> Tensor<S> operator+(const Tensor<S>& a, const Tensor<S>& b) { Tensor<S> r; apply_into(ops::Add{}, a, b, r); return r; }
+    template<typename S> Tensor<S> operator-(const Tensor<S>& a, const Tensor<S>& b) { Tensor<S> r; apply_into(ops::Sub{}, a, b, r); return r; }
+    template<typename S> Tensor<S> operator*(const Tensor<S>& a, const Tensor<S>& b) { Tensor<S> r; apply_into(ops::Mul{}, a, b, r); return r; }
+    template<typename S> Tensor<S> operator/(const Tensor<S>& a, const Tensor<S>& b) { Tensor<S> r; apply_into(ops::Div{}, a, b, r); return r; }
+    template<typename S> Tensor<S> operator-(const Tensor<S>& a) { Tensor<S> r; apply_into(ops::Neg{}, a, r); return r; }
+
+    template<typename S> Tensor<S> sin(const Tensor<S>& a) { Tensor<S> r; apply_into(ops::Sin{}, a, r); return r; }
+    template<typename S> Tensor<S> cos(const Tensor<S>& a) { Tensor<S> r; apply_into(ops::Cos{}, a, r); return r; }
+    template<typename S> Tensor<S> exp(const Tensor<S>& a) { Tensor<S> r; apply_into(ops::Exp{}, a, r); return r; }
+    template<typename S> Tensor<S> log(const Tensor<S>& a) { Tensor<S> r; apply_into(ops::Log{}, a, r); return r; }
+    template<typename S> Tensor<S> sqrt(const Tensor<S>& a) { Tensor<S> r; apply_into(ops::Sqrt{}, a, r); return r; }
+    template<typename S> Tensor<S> pow(const Tensor<S>& a, const Tensor<S>& b) { Tensor<S> r; apply_into(ops::Pow{}, a, b, r); return r; }
+
+    template<typename S>
+    bool identical(const Tensor<S>& a, const Tensor<S>& b) {
+        if (a.shape() != b.shape()) return false;
+        for (std::size_t i = 0; i < a.size(); ++i) {
+            if (!identical(a[i], b[i])) return false;
+        }
+        return true;
+    }
+
+    template<typename S>
+    std::ostream& operator<<(std::ostream& os, const Tensor<S>& t) {
+        if (t.size() == 1) return os << t[0];
+        os << "[";
+        for (std::size_t r = 0; r < t.rows(); ++r) {
+            os << (r ? ", [" : "[");
+            for (std::size_t c = 0; c < t.cols(); ++c) os << (c ? ", " : "") << t(r, c);
+            os << "]";
+        }
+        return os << "]";
+    }
+
+    // --------- DSL ---------
+
+    template<typename S>
+    Expression<Tensor<S>> matmul(Expression<Tensor<S>> a, Expression<Tensor<S>> b) {
+        return binary<Tensor<S>>(a, b, ops::MatMul{});
+    }
+
+    template<typename S>
+    Expression<Tensor<S>> sum(Expression<Tensor<S>> a) {
+        return unary<Tensor<S>>(a, ops::Sum{});
+    }
+
+} // namespace cg
+
+// lets tensor constants take part in cse (ConstantNode hashes its value)
+template<typename S>
+struct std::hash<cg::Tensor<S>> {
+    std::size_t operator()(const cg::Tensor<S>& t) const noexcept {
+        std::size_t seed = 0;
+        cg::hash_combine(seed, t.rows());
+        cg::hash_combine(seed, t.cols());
+        for (std::size_t i = 0; i < t.size(); ++i) cg::hash_combine(seed, std::hash<S>{}(t[i]));
+        return seed;
+    }
+};
@@ -13,6 +13,7 @@ namespace cg::viz {
 
         for (size_t i = 0; i < G.size(); ++i) {
             NodeID id{i};
+            if (!G.alive(id)) continue;
             const auto& node = G.node(id);
 
             std::string shape = "box";
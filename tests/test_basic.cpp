@@ -1,17 +1,58 @@
 #include <iostream>
 #include <cassert>
 #include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <thread>
+#include <vector>
 #include "cg/expression.hpp"
 #include "cg/dual.hpp"
+#include "cg/taylor.hpp"
+#include "cg/tensor.hpp"
 #include "cg/eval/evaluator.hpp"
 #include "cg/eval/policies.hpp"
+#include "cg/analysis/stats.hpp"
+#include "cg/analysis/allocations.hpp"
+#include "cg/frozen_graph.hpp"
+#include "cg/eval/bulk.hpp"
+#include "cg/eval/streaming.hpp"
+#include "cg/eval/service.hpp"
+#include "cg/eval/tiled.hpp"
+#include "cg/ad/jacobian.hpp"
+#include "cg/ad/hessian.hpp"
+#include "cg/opt/constant_folding.hpp"
+#include "cg/opt/value_numbering.hpp"
+#include "cg/function.hpp"
+#include "cg/scan.hpp"
+#include "cg/parse/parser.hpp"
+#include "cg/opt/fast_math.hpp"
+#include "cg/eval/fast_math.hpp"
+#include "cg/eval/mixed_precision.hpp"
 
 #define TESTCASE(name) void name()
 
+CG_DEFINE_COUNTING_ALLOCATOR()
+
 bool approx(double a, double b, double eps = 1e-9) {
     return std::abs(a - b) < eps;
 }
 
+// a user node with only the members Node had before batches, footprints and rewiring
+struct Doubler final : cg::Node<double> {
+    explicit Doubler(cg::NodeID in) : in_(in) {}
+    std::string_view kind() const noexcept override { return "doubler"; }
+    std::span<const cg::NodeID> inputs() const noexcept override { return std::span(&in_, 1); }
+    std::size_t hash() const noexcept override { return in_.index() * 31 + 7; }
+    bool is_equivalent(const cg::Node<double>& other) const noexcept override {
+        auto* d = dynamic_cast<const Doubler*>(&other);
+        return d && d->in_ == in_;
+    }
+    double evaluate_from_cache(std::span<const double> values) const override { return 2.0 * values[in_.index()]; }
+    std::string label() const noexcept override { return "2x"; }
+    cg::NodeID in_;
+};
+
 TESTCASE(test_arithmetic) {
     using T = double;
     cg::Graph<T> G;
@@ -34,6 +75,120 @@ TESTCASE(test_cse) {
     assert(G.size() == 4);
 }
 
+// every edge points forward in the maintained order and the consumer lists mirror the inputs
+template<typename T>
+bool consistent(const cg::Graph<T>& G) {
+    auto order = G.topological_sort();
+    if (order.size() != G.live()) return false;
+    std::vector<std::size_t> edges_in(G.size(), 0), edges_out(G.size(), 0);
+    for (auto id : order) {
+        for (auto dep : G.node(id).inputs()) {
+            if (!G.alive(dep) || !G.precedes(dep, id)) return false;
+            ++edges_in[dep.index()];
+        }
+        for (auto user : G.consumers(id)) {
+            if (!G.alive(user)) return false;
+        }
+        edges_out[id.index()] = G.consumers(id).size();
+    }
+    return edges_in == edges_out;
+}
+
+TESTCASE(test_graph_edits) {
+    using T = double;
+    using Add = cg::BinaryNode<T, cg::ops::Add>;
+    cg::Graph<T> G;
+    auto x = cg::input(G, "x");
+    auto y = cg::input(G, "y");
+    auto three = cg::constant(G, 3.0);
+    auto product = x * three;
+    auto f = product * y;
+
+    // the cse table follows a replace: x * 3 is new again, x + 3 is the replaced node
+    G.replace(product.root(), std::make_unique<Add>(x.root(), three.root(), cg::ops::Add{}));
+    assert((x + 3.0).root() == product.root());
+    assert((x * 3.0).root() != product.root());
+    cg::Evaluator<T, cg::eval::NaiveEvaluator> naive;
+    cg::Context<T> ctx{{"x", 2.0}, {"y", 5.0}};
+    assert(approx(naive.evaluate(G, f.root(), ctx), 25.0));
+
+    // feeding an older node from a newer one reorders just the two of them
+    auto late = cg::sin(y);
+    assert(G.precedes(product.root(), late.root()));
+    G.rewire(product.root(), 1, late.root());
+    assert(G.precedes(late.root(), product.root()) && consistent(G));
+    assert(approx(naive.evaluate(G, f.root(), ctx), (2.0 + std::sin(5.0)) * 5.0));
+
+    // closing a cycle throws and changes nothing
+    bool threw = false;
+    try { G.rewire(late.root(), 0, f.root()); } catch (const std::runtime_error&) { threw = true; }
+    assert(threw && consistent(G) && G.node(late.root()).inputs()[0] == y.root());
+
+    // dropping the old x * 3 takes the constant with it, nothing else used it
+    auto stale = (x * 3.0).root();
+    assert(G.remove(stale) == 2 && !G.alive(stale) && !G.alive(three.root()) && G.alive(x.root()));
+    threw = false;
+    try { G.node(stale); } catch (const std::runtime_error&) { threw = true; }
+    assert(threw);
+    auto orphan = cg::cos(x);
+    const cg::NodeID roots[] = {f.root()};
+    assert(G.remove_unreferenced(roots) == 1 && !G.alive(orphan.root()));
+    assert(consistent(G) && G.live() == 5);
+
+    // removed slots stay, a removed constant comes back under a fresh id
+    const std::size_t slots = G.size();
+    assert(G.constant(3.0).index() == slots);
+    cg::FrozenGraph<T> frozen(std::move(G));
+    assert(frozen.order().size() == 6);
+    const T inputs[] = {2.0, 5.0};
+    assert(approx(frozen.evaluate(f.root(), inputs), (2.0 + std::sin(5.0)) * 5.0));
+
+    // a long run of random rewires keeps the order valid
+    cg::Graph<T> H;
+    std::vector<cg::NodeID> ids{H.input("a"), H.input("b")};
+    for (int i = 0; i < 200; ++i) {
+        auto a = cg::Expression<T>(&H, ids[(i * 7) % ids.size()]);
+        auto b = cg::Expression<T>(&H, ids[(i * 13 + 1) % ids.size()]);
+        ids.push_back((i % 2 ? a + b : a * cg::sin(b)).root());
+    }
+    std::size_t rewired = 0;
+    for (std::size_t k = 0; k < 500; ++k) {
+        auto id = ids[(k * 2654435761u) % ids.size()];
+        auto to = ids[(k * 40503u + 17) % ids.size()];
+        if (H.node(id).inputs().empty()) continue;
+        try {
+            H.rewire(id, k % H.node(id).inputs().size(), to);
+            ++rewired;
+        } catch (const std::runtime_error&) {}
+    }
+    assert(rewired > 0 && consistent(H));
+
+    // removing the last user of an input keeps the input, handles to it stay usable
+    cg::Graph<T> K;
+    auto u = cg::input(K, "u");
+    auto two = cg::constant(K, 2.0);
+    assert(K.remove(cg::sin(u).root()) == 1 && K.alive(u.root()));
+    auto g = u * 2.0;
+    cg::Evaluator<T, cg::eval::LazyEvaluator> lazy;
+    cg::Context<T> at3{{"u", 3.0}};
+    assert(approx(naive.evaluate(K, g.root(), at3), 6.0) && approx(lazy.evaluate(K, g.root(), at3), 6.0));
+
+    // building on a removed node throws instead of pointing at a tombstone
+    auto half = u / 2.0;
+    assert(K.remove((half - two).root()) == 2 && !K.alive(half.root()));
+    threw = false;
+    try { (void)(half + 1.0); } catch (const std::runtime_error&) { threw = true; }
+    assert(threw && consistent(K));
+
+    // rewiring a node type without with_inputs throws and leaves it as it was
+    auto twice = cg::Expression<T>(&K, K.add(std::make_unique<Doubler>(u.root())));
+    auto sum = twice + 1.0;
+    threw = false;
+    try { K.rewire(twice.root(), 0, g.root()); } catch (const std::runtime_error&) { threw = true; }
+    assert(threw && K.node(twice.root()).inputs()[0] == u.root() && consistent(K));
+    assert(approx(naive.evaluate(K, sum.root(), at3), 7.0));
+}
+
 TESTCASE(test_ad) {
     using T = cg::Dual<double>;
     cg::Graph<T> G;
@@ -62,10 +217,1059 @@ TESTCASE(test_ad) {
     assert(approx(y_result.d, std::cos(yvalue) + xvalue));
 }
 
+TESTCASE(test_analysis) {
+    using T = double;
+    cg::Graph<T> G;
+    auto x = cg::input(G, "x");
+    auto y = cg::input(G, "y");
+    auto sub = cg::sin(x) * y;
+    auto expr = sub + sub / 2.0;
+
+    auto stats = cg::analysis::analyze(G);
+    assert(stats.nodes == 7 && G.consumers(expr.root()).empty() && G.node(expr.root()).label() == "+");
+    assert(stats.inputs == 2 && stats.constants == 1 && stats.ops == 4);
+    assert(stats.depth == 4);
+    assert(stats.width.size() == 5 && stats.width[0] == 3 && stats.max_width == 3);
+    assert(stats.op_counts["*"] == 1 && stats.op_counts["sin"] == 1);
+    assert(stats.transcendentals == 1 && stats.flops == 3);
+    assert(stats.shared_nodes == 1);
+    assert(stats.sharing_ratio > 1.0);
+    assert(stats.value_bytes == 7 * sizeof(T));
+
+    auto table = cg::analysis::CostTable::defaults();
+    table.costs["sin"] = 100.0;
+    auto weighted = cg::analysis::analyze(G, table);
+    assert(approx(weighted.critical_path_cost, 100.0 + 1.0 + 4.0 + 1.0));
+    assert(cg::analysis::suggest_execution(weighted, 1000) == cg::analysis::Execution::batched);
+    assert(cg::analysis::suggest_execution(weighted) == cg::analysis::Execution::serial);
+
+    // calls cost their body once per call, scans their step times the sequence length
+    cg::Graph<T> body;
+    auto a = cg::input(body, "a");
+    auto b = cg::input(body, "b");
+    auto wave = cg::sin(a);
+    auto pair = cg::make_function<T>("pair", std::move(body), {"a", "b"}, {(wave * b).root(), (wave + b).root()});
+    cg::Graph<T> step_body;
+    auto s0 = cg::input(step_body, "s");
+    auto e0 = cg::input(step_body, "x");
+    auto step = cg::make_function<T>("step", std::move(step_body), {"s", "x"}, {(s0 * 0.5 + e0).root()});
+    auto seq = std::make_shared<std::vector<T>>(1000, 1.0);
+
+    cg::Graph<T> H;
+    auto u = cg::input(H, "u");
+    auto v = cg::input(H, "v");
+    auto both = cg::call(pair, {u, v});
+    cg::scan(step, both[0] + both[1], seq);
+    cg::scan_states(step, u, std::make_shared<std::vector<T>>(3, 1.0));
+    auto nested = cg::analysis::analyze(H);
+    assert(nested.calls == 2 && nested.scans == 4 && nested.flops == 1 && nested.transcendentals == 0);
+    assert(approx(nested.call_cost, 22.0));
+    assert(approx(nested.scan_cost, 2.0 * 1000 + 2.0 * 3));
+    assert(approx(nested.total_cost, 22.0 + 1.0 + 2000.0 + 6.0));
+    assert(approx(nested.critical_path_cost, 22.0 + 1.0 + 2000.0));
+}
+
+TESTCASE(test_value_numbering) {
+    using T = double;
+    cg::Graph<T> G;
+    auto x = cg::input(G, "x");
+    auto two = cg::constant(G, 2.0);
+    // 2 + 3 and 1 + 4 only become the same constant once folded, and x * 5 twice with them
+    auto a = x * (two + 3.0);
+    auto b = x * (cg::constant(G, 1.0) + 4.0);
+    auto f = cg::sin(a) + cg::sin(b) * two;
+    cg::Evaluator<T, cg::eval::NaiveEvaluator> naive;
+    cg::Context<T> ctx{{"x", 0.3}};
+    const T before = naive.evaluate(G, f.root(), ctx);
+
+    cg::opt::ConstantFolding<T>().run(G, f.root());
+    const std::size_t folded = G.live();
+    cg::opt::ValueNumbering<T> gvn;
+    const cg::NodeID roots[] = {f.root()};
+    // the second 5, x * 5 and sin(x * 5)
+    assert(gvn.run(G, roots) == 3 && gvn.merged() == 3);
+    assert(gvn.canonical(b.root()) == a.root() && gvn.canonical(a.root()) == a.root());
+    assert(!G.alive(b.root()) && G.node(G.node(f.root()).inputs()[1]).inputs()[0] == G.node(f.root()).inputs()[0]);
+    // the sweep also drops the folded operands 2 + 3 left behind: 3, 1, 4 (2 still feeds the product)
+    assert(gvn.removed() == 6 && G.live() == folded - 6);
+    assert(approx(naive.evaluate(G, gvn.canonical(f.root()), ctx), before));
+
+    // nothing left to merge the second time round
+    assert(gvn.run(G) == 0 && gvn.removed() == 0);
+}
+
+TESTCASE(test_frozen) {
+    using T = double;
+    cg::Graph<T> G;
+    auto x = cg::input(G, "x");
+    auto y = cg::input(G, "y");
+    auto expr = cg::sin(x) * y + x / 2.0;
+    auto root = expr.root();
+
+    auto frozen = cg::freeze(std::move(G));
+    assert(frozen->inputs().size() == 2);
+    assert(frozen->slot("y") != cg::FrozenGraph<T>::npos);
+    assert(frozen->slot("z") == cg::FrozenGraph<T>::npos);
+
+    std::vector<std::thread> threads;
+    std::vector<int> ok(4, 0);
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&, t] {
+            bool good = true;
+            for (int i = 0; i < 1000; ++i) {
+                std::vector<T> row(2);
+                T xv = 0.001 * i + t;
+                T yv = 2.0 - t;
+                row[frozen->slot("x")] = xv;
+                row[frozen->slot("y")] = yv;
+                good = good && approx(frozen->evaluate(root, row), std::sin(xv) * yv + xv / 2.0);
+            }
+            ok[t] = good;
+        });
+    }
+    for (auto& th : threads) th.join();
+    for (int good : ok) assert(good);
+
+    cg::Context<T> ctx{{"x", 1.0}, {"y", 3.0}};
+    assert(approx(frozen->evaluate(root, ctx), std::sin(1.0) * 3.0 + 0.5));
+
+    // a short output span or a root outside the graph throws before anything is written
+    const cg::NodeID two_roots[] = {root, x.root()}, stray[] = {cg::NodeID{frozen->size()}};
+    T single[1];
+    for (auto roots : {std::span<const cg::NodeID>(two_roots), std::span<const cg::NodeID>(stray)}) {
+        bool threw = false;
+        try { frozen->evaluate(roots, ctx, std::span<T>(single)); } catch (const std::runtime_error&) { threw = true; }
+        assert(threw);
+        threw = false;
+        try { frozen->evaluate(roots, std::span<const T>(std::vector<T>{1.0, 3.0}), std::span<T>(single)); }
+        catch (const std::runtime_error&) { threw = true; }
+        assert(threw);
+    }
+
+    // nested frames hand out distinct buffers
+    auto outer = cg::eval::Scratch<T>::acquire(8);
+    const T* level;
+    {
+        auto inner = cg::eval::Scratch<T>::acquire(8);
+        assert(inner.values().data() != outer.values().data());
+        level = inner.values().data();
+    }
+    // a buffer that can't grow leaves the level free for the next frame
+    bool failed = false;
+    try { cg::eval::Scratch<T>::acquire(std::size_t(1) << 50); } catch (const std::exception&) { failed = true; }
+    assert(failed);
+    auto again = cg::eval::Scratch<T>::acquire(8);
+    assert(again.values().data() != outer.values().data() && again.values().data() == level);
+}
+
+TESTCASE(test_bulk) {
+    using T = double;
+    cg::Graph<T> G;
+    auto x = cg::input(G, "x");
+    auto y = cg::input(G, "y");
+    auto expr = cg::cos(x) * y - 3.0 / (y + 4.0);
+    auto root = expr.root();
+    auto frozen = cg::freeze(std::move(G));
+    const std::size_t sx = frozen->slot("x");
+    const std::size_t sy = frozen->slot("y");
+
+    const std::size_t rows = 1000;
+    std::vector<T> data(rows * 2);
+    std::vector<T> xs(rows), ys(rows);
+    for (std::size_t r = 0; r < rows; ++r) {
+        xs[r] = data[r * 2 + sx] = 0.01 * r;
+        ys[r] = data[r * 2 + sy] = 1.0 + 0.002 * r;
+    }
+
+    cg::eval::ThreadPool pool(3);
+    std::vector<T> out(rows);
+    cg::eval::bulk_evaluate(pool, *frozen, root, cg::eval::RowMajor<T>{data, 2}, std::span<T>(out),
+                            {.chunk_rows = 64});
+    for (std::size_t r = 0; r < rows; ++r) {
+        assert(approx(out[r], std::cos(xs[r]) * ys[r] - 3.0 / (ys[r] + 4.0)));
+    }
+
+    cg::eval::Columnar<T> columnar;
+    columnar.columns.resize(2);
+    columnar.columns[sx] = xs;
+    columnar.columns[sy] = ys;
+    std::vector<T> out2(rows);
+    cg::eval::bulk_evaluate(pool, *frozen, root, columnar, std::span<T>(out2));
+    assert(out == out2);
+
+    // without a pool it runs on the shared default one, which outlives the call
+    std::fill(out2.begin(), out2.end(), 0.0);
+    cg::eval::bulk_evaluate(*frozen, root, columnar, std::span<T>(out2));
+    assert(out == out2 && &cg::eval::default_pool() == &cg::eval::default_pool());
+
+    // a root outside the graph is rejected before any chunk runs
+    bool bad_root = false;
+    try {
+        cg::eval::bulk_evaluate(pool, *frozen, cg::NodeID{frozen->size()}, columnar, std::span<T>(out2));
+    } catch (const std::runtime_error&) { bad_root = true; }
+    assert(bad_root && out == out2);
+
+    // it runs in batches on the row-by-row default
+    cg::Graph<T> H;
+    auto hx = cg::input(H, "x");
+    auto twice = cg::Expression<T>(&H, H.add(std::make_unique<Doubler>(hx.root())));
+    auto sum = twice + 1.0;
+    cg::FrozenGraph<T> doubled(std::move(H));
+    cg::eval::bulk_evaluate(pool, doubled, sum.root(), cg::eval::Columnar<T>{{xs}}, std::span<T>(out));
+    for (std::size_t r = 0; r < rows; ++r) assert(out[r] == 2.0 * xs[r] + 1.0);
+}
+
+TESTCASE(test_streaming) {
+    using T = double;
+    namespace fs = std::filesystem;
+    const std::string in_path = (fs::temp_directory_path() / "cg_test_stream_in.cgc").string();
+    const std::string out_path = (fs::temp_directory_path() / "cg_test_stream_out.cgc").string();
+
+    const std::size_t rows = 1000;
+    {
+        // columns in a different order than the graph's inputs, plus one the graph doesn't use
+        auto file = cg::io::ColumnarFile<T>::create(in_path, rows, {"y", "unused", "x"});
+        for (std::size_t r = 0; r < rows; ++r) {
+            file.column(0)[r] = 1.0 + 0.5 * r;
+            file.column(1)[r] = -1.0;
+            file.column(2)[r] = 0.25 * r;
+        }
+    }
+
+    cg::Graph<T> G;
+    auto x = cg::input(G, "x");
+    auto y = cg::input(G, "y");
+    auto sum = x + y;
+    auto ratio = cg::sqrt(x) / y;
+    const cg::NodeID roots[] = {sum.root(), ratio.root()};
+    auto frozen = cg::freeze(std::move(G));
+
+    auto stats = cg::eval::stream_evaluate(*frozen, roots, {"sum", "ratio"}, in_path, out_path, {.block_rows = 96});
+    assert(stats.rows == rows && stats.blocks == 11);
+
+    auto out = cg::io::ColumnarFile<T>::open(out_path);
+    assert(out.rows() == rows && out.cols() == 2);
+    assert(out.column_index("ratio") == 1);
+    for (std::size_t r = 0; r < rows; ++r) {
+        const T xv = 0.25 * r, yv = 1.0 + 0.5 * r;
+        assert(approx(out.column(0)[r], xv + yv));
+        assert(approx(out.column(1)[r], std::sqrt(xv) / yv));
+    }
+    // the data offset doesn't depend on the host's page size
+    assert(out.offset(0) == cg::io::columnar_alignment);
+
+    // header counts that don't fit the file are rejected, including a row count whose byte size wraps
+    auto corrupt = [&](std::size_t field, std::uint64_t value) {
+        std::fstream f(out_path, std::ios::in | std::ios::out | std::ios::binary);
+        f.seekp(static_cast<std::streamoff>(sizeof(cg::io::columnar_magic) + field * sizeof(value)));
+        f.write(reinterpret_cast<const char*>(&value), sizeof(value));
+    };
+    for (auto [field, value] : {std::pair<std::size_t, std::uint64_t>{0, std::uint64_t(1) << 61}, {1, std::uint64_t(1) << 40}}) {
+        corrupt(field, value);
+        bool threw = false;
+        try { cg::io::ColumnarFile<T>::open(out_path); } catch (const std::runtime_error&) { threw = true; }
+        assert(threw);
+        corrupt(field, field == 0 ? rows : 2);
+    }
+    assert(cg::io::ColumnarFile<T>::open(out_path).rows() == rows);
+
+    // a root outside the graph is refused before the output file gets created
+    const std::string stray_path = (fs::temp_directory_path() / "cg_test_stream_stray.cgc").string();
+    const cg::NodeID stray[] = {cg::NodeID{frozen->size()}};
+    bool threw = false;
+    try { cg::eval::stream_evaluate(*frozen, stray, {"stray"}, in_path, stray_path); } catch (const std::runtime_error&) { threw = true; }
+    assert(threw && !fs::exists(stray_path));
+    // as is a graph input the file has no column for, and the input file as the output
+    cg::Graph<T> H;
+    auto needs_z = cg::input(H, "x") + cg::input(H, "z");
+    auto missing = cg::freeze(std::move(H));
+    const cg::NodeID z_root[] = {needs_z.root()};
+    threw = false;
+    try { cg::eval::stream_evaluate(*missing, z_root, {"z"}, in_path, stray_path); } catch (const std::runtime_error&) { threw = true; }
+    assert(threw && !fs::exists(stray_path));
+    threw = false;
+    try { cg::eval::stream_evaluate(*frozen, roots, {"sum", "ratio"}, in_path, in_path); } catch (const std::runtime_error&) { threw = true; }
+    assert(threw && cg::io::ColumnarFile<T>::open(in_path).rows() == rows);
+
+    fs::remove(in_path);
+    fs::remove(out_path);
+}
+
+TESTCASE(test_tiled) {
+    using T = double;
+    cg::Graph<T> G;
+    auto x = cg::input(G, "x");
+    auto y = cg::input(G, "y");
+    // a chain of small formulas with a running sum, long enough to need many partitions
+    auto acc = cg::constant(G, 0.0);
+    auto shared = cg::sin(x) * y;
+    for (int i = 0; i < 40; ++i) {
+        auto term = cg::exp(x * (0.01 * i)) - y / (1.0 + x * x + double(i));
+        acc = acc + term * (i % 3 ? shared : cg::cos(y));
+    }
+    auto other = shared + y;
+    cg::FrozenGraph<T> frozen(std::move(G));
+
+    const std::size_t rows = 1003;
+    std::vector<T> xs(rows), ys(rows), out(rows), expected(rows);
+    for (std::size_t r = 0; r < rows; ++r) {
+        xs[r] = std::sin(0.37 * r);
+        ys[r] = 0.5 + std::cos(0.11 * r);
+    }
+    cg::eval::Columnar<T> table{{xs, ys}};
+
+    const cg::NodeID roots[] = {acc.root(), other.root()};
+    // six columns of 8 rows per partition, 40 rows per block
+    cg::eval::TiledPlan<T> plan(frozen, roots, {8, 6 * 8 * sizeof(T), 40});
+    assert(plan.tile_rows() == 8 && plan.block_rows() == 40 && plan.partitions().size() > 10);
+    assert(plan.boundary_values() < frozen.size() && plan.wide_slots() < plan.boundary_values());
+
+    cg::eval::ThreadPool pool(2);
+    std::vector<T> out2(rows);
+    const std::span<T> outs[] = {out, out2};
+    cg::eval::tiled_evaluate(pool, plan, table, std::span<const std::span<T>>(outs));
+    for (std::size_t i = 0; i < 2; ++i) {
+        for (std::size_t r = 0; r < rows; ++r) {
+            const T row[] = {xs[r], ys[r]};
+            assert(approx(outs[i][r], frozen.evaluate(roots[i], row), 1e-12));
+        }
+    }
+    cg::eval::tiled_evaluate(pool, plan, other.root(), table, std::span<T>(expected));
+    assert(expected == out2);
+
+    // auto-tuned from the cache sizes, how it partitions depends on the host
+    cg::eval::TiledPlan<T> tuned(frozen, roots);
+    assert(tuned.tile_rows() % 8 == 0);
+    assert(cg::eval::cache_sizes().l2 > 0);
+    cg::eval::tiled_evaluate(pool, tuned, acc.root(), table, std::span<T>(out));
+    cg::eval::bulk_evaluate(pool, frozen, acc.root(), table, std::span<T>(expected));
+    for (std::size_t r = 0; r < rows; ++r) assert(approx(out[r], expected[r], 1e-12));
+
+    bool threw = false;
+    try { cg::eval::tiled_evaluate(pool, plan, shared.root(), table, std::span<T>(out)); } catch (const std::runtime_error&) { threw = true; }
+    assert(threw);
+    // a block longer than the plan's boundary columns is refused
+    threw = false;
+    try { plan.evaluate_block(acc.root(), table, 0, 41, std::span<T>(out)); } catch (const std::runtime_error&) { threw = true; }
+    assert(threw);
+    // so are rows past the end of the table and a table missing an input column
+    threw = false;
+    try { plan.evaluate_block(acc.root(), table, rows - 10, 20, std::span<T>(out)); } catch (const std::runtime_error&) { threw = true; }
+    assert(threw);
+    threw = false;
+    try {
+        plan.evaluate_block(acc.root(), cg::eval::Columnar<T>{{xs}}, 0, 8, std::span<T>(out));
+    } catch (const std::runtime_error&) { threw = true; }
+    assert(threw);
+    // and a plan for a root that isn't in the graph
+    threw = false;
+    const cg::NodeID stray[] = {cg::NodeID{frozen.size()}};
+    try { cg::eval::TiledPlan<T> broken(frozen, stray); } catch (const std::runtime_error&) { threw = true; }
+    assert(threw);
+}
+
+TESTCASE(test_service) {
+    using T = double;
+    cg::Graph<T> G;
+    auto x = cg::input(G, "x");
+    auto y = cg::input(G, "y");
+    auto f = x * y + cg::sin(x);
+    auto g = x - y;
+    auto frozen = cg::freeze(std::move(G));
+
+    for (bool batching : {true, false}) {
+        // the budget never runs out, only the 32nd request releases the batch
+        cg::eval::BatchingService<T> service(frozen, {std::chrono::hours(1), 32, batching});
+        std::vector<std::thread> clients;
+        std::vector<std::vector<std::pair<std::future<T>, T>>> results(4);
+        for (int c = 0; c < 4; ++c) {
+            clients.emplace_back([&, c] {
+                for (int i = 0; i < 8; ++i) {
+                    const T row[] = {0.25 * i + c, 1.5 - c};
+                    const auto root = i % 2 ? f.root() : g.root();
+                    results[c].emplace_back(service.submit(root, row), frozen->evaluate(root, row));
+                }
+            });
+        }
+        for (auto& t : clients) t.join();
+        for (auto& client : results) {
+            for (auto& [future, expected] : client) assert(approx(future.get(), expected));
+        }
+        const auto stats = service.stats();
+        assert(stats.requests == 32);
+        assert(stats.batches == (batching ? 1 : 32));
+    }
+
+    // bad requests throw in submit, never on the dispatcher thread
+    cg::eval::BatchingService<T> service(frozen);
+    const T short_row[] = {1.0}, row[] = {1.0, 2.0};
+    const cg::NodeID missing{frozen->size() + 5};
+    for (auto [root, values] : {std::pair{f.root(), std::span<const T>(short_row)}, {missing, std::span<const T>(row)}}) {
+        bool threw = false;
+        try { service.submit(root, values); } catch (const std::runtime_error&) { threw = true; }
+        assert(threw);
+    }
+    assert(service.stats().requests == 0);
+}
+
+TESTCASE(test_sparse_jacobian) {
+    using T = cg::Dual<double>;
+    cg::Graph<T> G;
+    auto x = cg::input(G, "x");
+    auto y = cg::input(G, "y");
+    auto z = cg::input(G, "z");
+    auto w = cg::input(G, "w");
+    const cg::NodeID outputs[] = {(x * y).root(), cg::sin(z).root(), (w * z).root()};
+
+    cg::Context<double> at{{"x", 2.0}, {"y", 3.0}, {"z", 0.5}, {"w", -1.5}};
+    auto result = cg::ad::jacobian(G, outputs, at);
+
+    // {x, y} and {w, z} conflict, so two colours cover all four inputs
+    assert(result.passes == 2);
+    assert(result.J.rows == 3 && result.J.cols == 4 && result.J.nonzeros() == 5);
+
+    auto col = [&](cg::NodeID id) {
+        for (std::size_t c = 0; c < result.inputs.size(); ++c) {
+            if (result.inputs[c] == id) return c;
+        }
+        return result.inputs.size();
+    };
+    assert(approx(result.J.at(0, col(x.root())), 3.0));
+    assert(approx(result.J.at(0, col(y.root())), 2.0));
+    assert(approx(result.J.at(0, col(z.root())), 0.0));
+    assert(approx(result.J.at(1, col(z.root())), std::cos(0.5)));
+    assert(approx(result.J.at(2, col(w.root())), 0.5));
+    assert(approx(result.J.at(2, col(z.root())), -1.5));
+
+    // nodes outside the outputs' cone don't change anything, an output outside the graph throws
+    auto unrelated = cg::exp(x * w) + cg::cos(y);
+    auto again = cg::ad::jacobian(G, outputs, at);
+    assert(again.J.values == result.J.values && G.consumers(unrelated.root()).empty());
+    const cg::NodeID stray[] = {cg::NodeID{G.size()}};
+    bool threw = false;
+    try { cg::ad::jacobian(G, stray, at); } catch (const std::runtime_error&) { threw = true; }
+    assert(threw);
+}
+
+TESTCASE(test_nested_dual) {
+    using T = cg::ad::HyperDual<double>;
+    cg::Graph<T> G;
+    auto x = cg::input(G, "x");
+    auto y = cg::input(G, "y");
+    // constants need std::hash<Dual>, every op of dual.hpp shows up once. plain scalars convert
+    auto expr = cg::pow(x, 3.0) * y + cg::log(x) * cg::sqrt(y) - cg::exp(x) / 2.0 + cg::cos(y) * cg::sin(x);
+    assert(G.node(G.constant(T(3.0))).kind() == "const");
+    const T h = 1.5;
+    assert((2.0 * h).value.value == 3.0 && (h / 2.0).value.value == 0.75 && (3.0 / h).value.value == 2.0);
+
+    cg::opt::ConstantFolding<T> folding;
+    folding.run(G, expr.root());
+
+    const double xv = 1.3, yv = 0.7;
+    cg::Context<double> at{{"x", xv}, {"y", yv}};
+    cg::Context<double> v{{"x", 0.5}, {"y", -2.0}};
+    auto r = cg::ad::hvp(G, expr.root(), at, v);
+
+    auto f = [](double a, double b) {
+        return std::pow(a, 3.0) * b + std::log(a) * std::sqrt(b) - std::exp(a) / 2.0 + std::cos(b) * std::sin(a);
+    };
+    const double fxx = 6 * xv * yv - std::sqrt(yv) / (xv * xv) - std::exp(xv) / 2.0 - std::cos(yv) * std::sin(xv);
+    const double fxy = 3 * xv * xv + 1.0 / (2 * xv * std::sqrt(yv)) - std::sin(yv) * std::cos(xv);
+    const double fyy = -std::log(xv) / (4 * yv * std::sqrt(yv)) - std::cos(yv) * std::sin(xv);
+
+    assert(r.inputs.size() == 2 && r.inputs[0] == x.root());
+    assert(approx(r.value, f(xv, yv)));
+    assert(approx(r.hv[0], fxx * 0.5 + fxy * -2.0));
+    assert(approx(r.hv[1], fxy * 0.5 + fyy * -2.0));
+    assert(approx(r.gradient[1], xv * xv * xv + std::log(xv) / (2 * std::sqrt(yv)) - std::sin(yv) * std::sin(xv)));
+}
+
+TESTCASE(test_taylor) {
+    // f(x) = sin(x) * exp(x) / sqrt(x) + log(x) * x^2.5 - cos(x) * 3, built once per value type
+    auto build = []<typename V>(cg::Graph<V>& G) {
+        auto x = cg::input(G, "x");
+        return (cg::sin(x) * cg::exp(x) / cg::sqrt(x) + cg::log(x) * cg::pow(x, V(2.5)) - cg::cos(x) * V(3.0)).root();
+    };
+    const double xv = 0.8;
+
+    using Tay = cg::Taylor<double, 3>;
+    cg::Graph<Tay> G;
+    auto root = build(G);
+    cg::Evaluator<Tay, cg::eval::NaiveEvaluator> taylor;
+    Tay t = taylor.evaluate(G, root, {{"x", Tay::variable(xv)}});
+
+    using DD = cg::ad::HyperDual<double>;
+    cg::Graph<DD> H;
+    auto root2 = build(H);
+    cg::Evaluator<DD, cg::eval::NaiveEvaluator> nested;
+    DD d = nested.evaluate(H, root2, {{"x", DD(cg::Dual<double>(xv, 1.0), cg::Dual<double>(1.0, 0.0))}});
+
+    assert(approx(t.value(), d.value.value));
+    assert(approx(t.derivative(1), d.value.d));
+    assert(approx(t.derivative(2), d.d.d));
+
+    // higher orders against closed forms: d^k/dx^k exp(2x) = 2^k exp(2x), d^k/dx^k x^-1 = (-1)^k k! x^-(k+1)
+    using Tay6 = cg::Taylor<double, 7>;
+    cg::Graph<Tay6> F;
+    auto y = cg::input(F, "y");
+    auto e2 = cg::exp(y * Tay6(2.0));
+    auto inv = Tay6(1.0) / y;
+    cg::Evaluator<Tay6, cg::eval::NaiveEvaluator> eval6;
+    cg::Context<Tay6> ctx{{"y", Tay6::variable(xv)}};
+    Tay6 a = eval6.evaluate(F, e2.root(), ctx);
+    Tay6 b = eval6.evaluate(F, inv.root(), ctx);
+    double fact = 1.0;
+    for (std::size_t k = 0; k < 7; ++k) {
+        if (k > 0) fact *= k;
+        assert(approx(a.derivative(k), std::pow(2.0, k) * std::exp(2 * xv), 1e-6));
+        assert(approx(b.derivative(k), (k % 2 ? -1.0 : 1.0) * fact / std::pow(xv, k + 1), 1e-6));
+    }
+
+    // constant exponents at a zero base: whole powers are exact, fractional ones diverge past t^r
+    const Tay zero = Tay::variable(0.0);
+    const Tay sq = cg::pow(zero, Tay(2.0));
+    assert(sq.derivative(0) == 0.0 && sq.derivative(1) == 0.0 && sq.derivative(2) == 2.0);
+    assert(cg::pow(zero, Tay(0.0)) == Tay(1.0) && cg::pow(zero, Tay(5.0)) == Tay(0.0));
+    const Tay root_half = cg::pow(zero, Tay(0.5));
+    assert(root_half.value() == 0.0 && std::isinf(root_half.c[1]) && root_half.c[1] > 0);
+    // (t^2)^1.5 = t^3 stays a power series
+    const Tay6 cube = cg::pow(Tay6::variable(0.0) * Tay6::variable(0.0), Tay6(1.5));
+    for (std::size_t k = 0; k < 7; ++k) assert(cube.derivative(k) == (k == 3 ? 6.0 : 0.0));
+
+    bool threw = false;
+    try { (void)sq.derivative(3); } catch (const std::runtime_error&) { threw = true; }
+    assert(threw);
+}
+
+TESTCASE(test_memory) {
+    using T = double;
+    cg::Graph<T> G;
+    auto x = cg::input(G, "x");
+    auto rate = cg::input(G, "a_rather_long_interest_rate_name_that_lives_on_the_heap");
+    auto f = cg::exp(rate * x) + x * 2.0;
+
+    // node types without a footprint of their own count as the base object
+    auto twice = cg::Expression<T>(&G, G.add(std::make_unique<Doubler>(x.root())));
+    assert(G.node(twice.root()).footprint() == sizeof(cg::Node<T>));
+
+    const auto m = G.memory();
+    assert(m.names > 40 && m.nodes > 0 && m.cse_table > 0 && m.consumers > 0 && m.order > 0);
+    assert(m.total() == m.nodes + m.names + m.node_table + m.cse_table + m.consumers + m.order);
+    assert(cg::eval::NaiveEvaluator::memory(G).values == G.size() * sizeof(T));
+    cg::Evaluator<T, cg::eval::LazyEvaluator> lazy;
+    assert(lazy.memory(G).schedule > 0);
+
+    // the frozen path is allocation free once this thread's scratch frame exists
+    assert(cg::analysis::counting_allocations());
+    cg::FrozenGraph<T> frozen(std::move(G));
+    const T inputs[] = {0.5, 0.1};
+    T out = frozen.evaluate(f.root(), inputs);
+    auto steady = cg::analysis::count_allocations([&] { out = frozen.evaluate(f.root(), inputs); });
+    assert(steady.allocations == 0 && steady.peak_bytes == 0);
+    assert(frozen.memory().values == frozen.size() * sizeof(T));
+
+    // the naive policy allocates its value buffer and order on every call, and frees them again
+    cg::Context<T> ctx{{"x", 0.5}, {"a_rather_long_interest_rate_name_that_lives_on_the_heap", 0.1}};
+    cg::Evaluator<T, cg::eval::NaiveEvaluator> naive;
+    auto per_call = cg::analysis::count_allocations([&] { assert(approx(naive.evaluate(frozen.graph(), f.root(), ctx), out)); });
+    assert(per_call.allocations >= 2 && per_call.deallocations == per_call.allocations);
+    assert(per_call.peak_bytes >= cg::eval::NaiveEvaluator::memory(frozen.graph()).total());
+
+    // tensors reuse their slots too
+    using M = cg::Tensor<double>;
+    cg::Graph<M> H;
+    auto W = cg::input(H, "W");
+    auto v = cg::input(H, "v");
+    auto y = cg::sum(cg::sin(cg::matmul(W, v)) * v);
+    cg::FrozenGraph<M> layer(std::move(H));
+    const M args[] = {M(2, 2, {1, 2, 3, 4}), M::column({0.5, -0.5})};
+    M result;
+    layer.evaluate(y.root(), args, result);
+    assert(cg::analysis::count_allocations([&] { layer.evaluate(y.root(), args, result); }).allocations == 0);
+
+    // scopes nest, the outer one sees the inner one's traffic
+    cg::analysis::AllocationScope outer;
+    auto inner = cg::analysis::count_allocations([] { std::vector<double> v(1000); });
+    assert(inner.allocations == 1 && inner.bytes == 1000 * sizeof(double) && inner.peak_bytes == inner.bytes);
+    assert(outer.stats().allocations == 1 && outer.stats().peak_bytes == inner.bytes);
+}
+
+// the identity, counting how often it runs
+struct CountingIdentity {
+    static constexpr auto symbol = "id";
+    static inline std::size_t calls = 0;
+    double operator()(double x) const { ++calls; return x; }
+};
+
+TESTCASE(test_function_call) {
+    using T = double;
+    // body(a, b) = {a * a + sin(b), a - b}
+    cg::Graph<T> body;
+    auto a = cg::input(body, "a");
+    auto b = cg::input(body, "b");
+    auto f0 = a * a + cg::sin(b);
+    auto f1 = a - b;
+    auto fn = cg::make_function<T>("f", std::move(body), {"b", "a"}, {f0.root(), f1.root()});
+
+    auto reference = [](T x, T y) { return (y * y + std::sin(x)) * (y - x) + (x * x + std::sin(y)); };
+
+    std::size_t sizes[2];
+    for (auto mode : {cg::CallMode::shared, cg::CallMode::inlined}) {
+        cg::Graph<T> G;
+        auto x = cg::input(G, "x");
+        auto y = cg::input(G, "y");
+        auto r1 = cg::call(fn, {x, y}, mode); // b = x, a = y
+        auto r2 = cg::call(fn, {y, x}, mode);
+        auto expr = r1[0] * r1[1] + r2[0];
+        sizes[mode == cg::CallMode::shared] = G.size();
+
+        cg::Evaluator<T, cg::eval::NaiveEvaluator> naive;
+        cg::Evaluator<T, cg::eval::LazyEvaluator> lazy;
+        cg::Context<T> ctx{{"x", 0.4}, {"y", 1.7}};
+        assert(approx(naive.evaluate(G, expr.root(), ctx), reference(0.4, 1.7)));
+        assert(approx(lazy.evaluate(G, expr.root(), ctx), reference(0.4, 1.7)));
+
+        // batches and frozen graphs run calls too, including calls nested in other function bodies
+        cg::Graph<T> outer_body;
+        auto p = cg::input(outer_body, "p");
+        auto q = cg::call(fn, {p, p * 2.0}, mode)[0];
+        auto outer = cg::make_function<T>("g", std::move(outer_body), {"p"}, {q.root()});
+        auto nested = cg::call(outer, {expr}, mode)[0];
+
+        auto frozen = cg::freeze(std::move(G));
+        std::vector<T> data{0.4, 1.7, 0.9, -0.3};
+        std::vector<T> out(2);
+        cg::eval::bulk_evaluate(*frozen, nested.root(), cg::eval::RowMajor<T>{data, 2}, std::span<T>(out));
+        for (std::size_t r = 0; r < 2; ++r) {
+            T e = reference(data[2 * r + frozen->slot("x")], data[2 * r + frozen->slot("y")]);
+            assert(approx(out[r], (2 * e) * (2 * e) + std::sin(e)));
+        }
+    }
+    assert(sizes[1] < sizes[0]);
+
+    // one body run serves every output of a call, in single and in batch evaluation
+    cg::Graph<T> counted;
+    auto u = cg::input(counted, "u");
+    auto seen = cg::Expression<T>(&counted, counted.add(std::make_unique<cg::UnaryNode<T, CountingIdentity>>(u.root())));
+    auto pair = cg::make_function<T>("pair", std::move(counted), {"u"}, {(seen * 2.0).root(), (seen + 1.0).root()});
+    cg::Graph<T> G;
+    auto x = cg::input(G, "x");
+    auto both = cg::call(pair, {x});
+    auto sum = both[0] + both[1];
+    CountingIdentity::calls = 0;
+    assert(approx(cg::Evaluator<T, cg::eval::NaiveEvaluator>().evaluate(G, sum.root(), {{"x", 3.0}}), 10.0));
+    assert(CountingIdentity::calls == 1);
+
+    // nullary functions take the graph explicitly
+    cg::Graph<T> constant_body;
+    auto six = cg::constant(constant_body, 2.0) * 3.0;
+    auto answer = cg::make_function<T>("six", std::move(constant_body), {}, {six.root()});
+    auto called = cg::call(G, answer, {})[0];
+    auto total = sum * called;
+    bool threw = false;
+    try { cg::call(answer, {}); } catch (const std::runtime_error&) { threw = true; }
+    assert(threw);
+
+    auto frozen = cg::freeze(std::move(G));
+    std::vector<T> xs(300), out(300);
+    for (std::size_t r = 0; r < xs.size(); ++r) xs[r] = 0.1 * r;
+    CountingIdentity::calls = 0;
+    cg::eval::bulk_evaluate(*frozen, total.root(), cg::eval::Columnar<T>{{xs}}, std::span<T>(out));
+    assert(CountingIdentity::calls == xs.size());
+    for (std::size_t r = 0; r < xs.size(); ++r) assert(approx(out[r], 6.0 * (3.0 * xs[r] + 1.0)));
+
+    // the call memo tells -0.0 from +0.0, 1 / a is +inf for one and -inf for the other
+    cg::Graph<T> inverse_body;
+    auto ia = cg::input(inverse_body, "a");
+    auto inv = 1.0 / ia;
+    auto inverse = cg::make_function<T>("inverse", std::move(inverse_body), {"a"}, {inv.root(), (ia * 2.0).root()});
+    cg::Graph<T> Z;
+    auto zp = cg::input(Z, "zp");
+    auto zn = cg::input(Z, "zn");
+    auto inf_p = cg::call(inverse, {zp})[0];
+    auto inf_n = cg::call(inverse, {zn})[0];
+    cg::Evaluator<T, cg::eval::NaiveEvaluator> naive;
+    cg::Context<T> zeros{{"zp", 0.0}, {"zn", -0.0}};
+    assert(naive.evaluate(Z, inf_p.root(), zeros) == std::numeric_limits<T>::infinity());
+    assert(naive.evaluate(Z, inf_n.root(), zeros) == -std::numeric_limits<T>::infinity());
+    const T signed_zeros[] = {0.0, -0.0};
+    assert(inverse->invoke([&](std::size_t) { return signed_zeros[0]; }, 0) > 0.0);
+    assert(inverse->invoke([&](std::size_t) { return signed_zeros[1]; }, 0) < 0.0);
+
+    // a single-output function keeps no memo, there's no sibling output to share a run with
+    cg::Graph<T> single_body;
+    auto su = cg::input(single_body, "u");
+    auto single_seen = cg::Expression<T>(&single_body, single_body.add(
+        std::make_unique<cg::UnaryNode<T, CountingIdentity>>(su.root())));
+    auto single = cg::make_function<T>("single", std::move(single_body), {"u"}, {(single_seen * 2.0).root()});
+    CountingIdentity::calls = 0;
+    const T one[] = {1.0};
+    assert((*single)(one) == 2.0 && (*single)(one) == 2.0 && CountingIdentity::calls == 2);
+}
+
+TESTCASE(test_scan) {
+    // s[t] = a * s[t - 1] + x[t], derivative with respect to the decay a through Dual
+    using T = cg::Dual<double>;
+    cg::Graph<T> body;
+    auto s = cg::input(body, "s");
+    auto x = cg::input(body, "x");
+    auto a = cg::input(body, "a");
+    auto next = a * s + x;
+    auto step = cg::make_function<T>("ema", std::move(body), {"s", "x", "a"}, {next.root()});
+
+    const std::size_t steps = 100000;
+    auto xs = std::make_shared<std::vector<T>>();
+    for (std::size_t t = 0; t < steps; ++t) xs->push_back(T(std::sin(0.001 * t)));
+
+    cg::Graph<T> G;
+    auto s0 = cg::input(G, "s0");
+    auto decay = cg::input(G, "decay");
+    auto final_state = cg::scan(step, s0, xs, {decay});
+    assert(G.size() == 3);
+
+    const double av = 0.999, s0v = 2.0;
+    double ref = s0v, dref = 0.0;
+    for (const auto& xt : *xs) {
+        dref = ref + av * dref;
+        ref = av * ref + xt.value;
+    }
+
+    cg::Evaluator<T, cg::eval::LazyEvaluator> lazy;
+    T r = lazy.evaluate(G, final_state.root(), {{"s0", T(s0v)}, {"decay", T(av, 1.0)}});
+    assert(approx(r.value, ref, 1e-6));
+    assert(approx(r.d, dref, 1e-4 * std::abs(dref)));
+
+    auto states = cg::run_scan<T>(*step, T(s0v), std::span<const T>(xs->data(), 3), std::vector<T>{T(av)},
+                                  cg::ScanOutput::all_states);
+    assert(states.size() == 3);
+    assert(approx(states[1].value, av * (av * s0v + xs->at(0).value) + xs->at(1).value));
+
+    // every state as a node of its own, in single and batch evaluation
+    cg::Graph<double> ema_body;
+    auto bs = cg::input(ema_body, "s");
+    auto bx = cg::input(ema_body, "x");
+    auto ba = cg::input(ema_body, "a");
+    auto ema = cg::make_function<double>("ema", std::move(ema_body), {"s", "x", "a"}, {(ba * bs + bx).root()});
+    auto seq = std::make_shared<std::vector<double>>(std::vector<double>{1.0, -2.0, 0.5, 4.0});
+    cg::Graph<double> S;
+    auto start = cg::input(S, "s0");
+    auto rate = cg::input(S, "a");
+    auto each = cg::scan_states(ema, start, seq, {rate});
+    auto last = cg::scan(ema, start, seq, {rate});
+    assert(each.size() == 4 && S.size() == 7);
+
+    auto frozen = cg::freeze(std::move(S));
+    std::vector<double> s0s, rates, got(16);
+    for (int r = 0; r < 16; ++r) {
+        s0s.push_back(0.1 * r);
+        rates.push_back(0.9 - 0.05 * r);
+    }
+    assert(frozen->slot("s0") == 0 && frozen->slot("a") == 1);
+    cg::eval::Columnar<double> table{{s0s, rates}};
+    for (std::size_t t = 0; t <= each.size(); ++t) {
+        const auto root = t < each.size() ? each[t].root() : last.root();
+        cg::eval::bulk_evaluate(*frozen, root, table, std::span<double>(got));
+        for (std::size_t r = 0; r < got.size(); ++r) {
+            const double inv[] = {rates[r]};
+            auto expect = cg::run_scan<double>(*ema, s0s[r], *seq, inv, cg::ScanOutput::all_states);
+            const double want = t < each.size() ? expect[t] : expect.back();
+            assert(approx(got[r], want));
+            const double row[] = {s0s[r], rates[r]};
+            assert(approx(frozen->evaluate(root, row), want));
+        }
+    }
+
+    // the states memo tells -0.0 from +0.0 and a nan init still shares one run per group
+    cg::Graph<double> scale_body;
+    auto ss = cg::input(scale_body, "s");
+    auto sx = cg::input(scale_body, "x");
+    auto counted_s = cg::Expression<double>(&scale_body, scale_body.add(
+        std::make_unique<cg::UnaryNode<double, CountingIdentity>>(ss.root())));
+    auto scale = cg::make_function<double>("scale", std::move(scale_body), {"s", "x"}, {(counted_s * sx).root()});
+    auto factors = std::make_shared<std::vector<double>>(std::vector<double>{1.0, 2.0, 3.0});
+    cg::Graph<double> Z;
+    auto pos = cg::scan_states(scale, cg::input(Z, "p"), factors);
+    auto neg = cg::scan_states(scale, cg::input(Z, "n"), factors);
+    std::vector<cg::NodeID> roots;
+    for (const auto& e : pos) roots.push_back(e.root());
+    for (const auto& e : neg) roots.push_back(e.root());
+    auto zeros = cg::freeze(std::move(Z));
+    std::vector<double> states_out(roots.size());
+    CountingIdentity::calls = 0;
+    zeros->evaluate(roots, cg::Context<double>{{"p", 0.0}, {"n", -0.0}}, std::span<double>(states_out));
+    for (std::size_t t = 0; t < factors->size(); ++t) {
+        assert(states_out[t] == 0.0 && !std::signbit(states_out[t]));
+        assert(states_out[factors->size() + t] == 0.0 && std::signbit(states_out[factors->size() + t]));
+    }
+    assert(CountingIdentity::calls == 2 * factors->size());
+    CountingIdentity::calls = 0;
+    zeros->evaluate(roots, cg::Context<double>{{"p", std::nan("")}, {"n", 1.0}}, std::span<double>(states_out));
+    assert(std::isnan(states_out[0]) && states_out.back() == 6.0);
+    assert(CountingIdentity::calls == 2 * factors->size());
+    // the memo doesn't keep the step or the sequence alive once the graph is gone
+    std::weak_ptr<std::vector<double>> watched = factors;
+    zeros.reset();
+    factors.reset();
+    scale.reset();
+    assert(watched.expired());
+
+    cg::Graph<double> chain;
+    auto c = cg::input(chain, "c");
+    auto acc = c;
+    for (int i = 0; i < 200000; ++i) acc = acc * 0.5 + c;
+    cg::Evaluator<double, cg::eval::LazyEvaluator> deep;
+    assert(approx(deep.evaluate(chain, acc.root(), {{"c", 1.0}}), 2.0));
+}
+
+TESTCASE(test_parser) {
+    using T = double;
+    cg::Graph<T> G;
+    cg::parse::Parser<T> parser(G);
+
+    const std::string_view formulas[] = {
+        "sin(x) * (y + 2) + 3 * 5 + x^2",
+        "-x^2 + pow(y, 0.5) / exp(-x)",
+        "2 ^ 3 ^ 2 - log(sqrt(y)) * cos(x)",
+        "x^2 + sin(x) * (y + 2)",
+    };
+    cg::NodeID roots[4];
+    parser.parse_all(formulas, roots);
+
+    cg::Evaluator<T, cg::eval::NaiveEvaluator> naive;
+    cg::Context<T> ctx{{"x", 0.7}, {"y", 2.5}};
+    const T x = 0.7, y = 2.5;
+    assert(approx(naive.evaluate(G, roots[0], ctx), std::sin(x) * (y + 2) + 15 + x * x));
+    assert(approx(naive.evaluate(G, roots[1], ctx), -(x * x) + std::sqrt(y) / std::exp(-x)));
+    assert(approx(naive.evaluate(G, roots[2], ctx), 512.0 - std::log(std::sqrt(y)) * std::cos(x)));
+
+    // the last formula only reuses nodes of the first one
+    const auto before = G.size();
+    assert(parser.parse("x^2 + sin(x) * (y + 2)") == roots[3]);
+    assert(G.size() == before);
+
+    for (auto bad : {"x +", "sin(x", "foo(x)", "2 $ 3", "pow(x)", "(x))"}) {
+        bool threw = false;
+        try { parser.parse(bad); } catch (const std::runtime_error&) { threw = true; }
+        assert(threw);
+    }
+    // a root span shorter than the formulas is refused before anything is parsed
+    cg::NodeID two[2];
+    bool short_span = false;
+    try { parser.parse_all(formulas, two); } catch (const std::runtime_error&) { short_span = true; }
+    assert(short_span && G.size() == before);
+
+    // the parser's cached input ids survive a remove and a sweep
+    cg::Graph<T> H;
+    cg::parse::Parser<T> fresh(H);
+    H.remove(fresh.parse("sin(x)"));
+    assert(approx(naive.evaluate(H, fresh.parse("x * 2"), cg::Context<T>{{"x", 3.0}}), 6.0));
+    fresh.parse("cos(z) + 1");
+    const cg::NodeID kept[] = {fresh.parse("y - 1")};
+    assert(H.remove_unreferenced(kept) == 4 && H.alive(*H.find(cg::InputNode<T>("z"))));
+    const cg::Context<T> at{{"x", 3.0}, {"y", 0.0}, {"z", 0.0}};
+    assert(approx(naive.evaluate(H, fresh.parse("z + x * 2"), at), 6.0));
+
+    // an input removed explicitly is rebuilt instead of read from the cache
+    cg::Graph<T> K;
+    cg::parse::Parser<T> again(K);
+    const auto w = again.parse("w");
+    K.remove(w);
+    const auto rebuilt = again.parse("w + 1");
+    assert(K.alive(K.node(rebuilt).inputs()[0]) && K.node(rebuilt).inputs()[0] != w);
+    assert(approx(naive.evaluate(K, rebuilt, cg::Context<T>{{"w", 2.0}}), 3.0));
+}
+
+TESTCASE(test_fast_math) {
+    using T = double;
+    auto rel = [](double a, double b) { return std::abs(a - b) / std::max(std::abs(b), 1e-300); };
+
+    // kernels against libm over their domains, scalar and span variants
+    std::vector<double> xs, out(2001);
+    for (int i = 0; i <= 2000; ++i) xs.push_back(-700.0 + 0.7 * i);
+    cg::fast::exp(xs, out);
+    for (std::size_t i = 0; i < xs.size(); ++i) {
+        assert(rel(cg::fast::exp(xs[i]), std::exp(xs[i])) < 1e-11);
+        assert(out[i] == cg::fast::exp(xs[i]));
+    }
+    for (double x = 1e-300; x < 1e300; x *= 1.7) assert(rel(cg::fast::log(x), std::log(x)) < 2e-12);
+    for (double x = -1e4; x < 1e4; x += 0.37) {
+        assert(std::abs(cg::fast::sin(x) - std::sin(x)) < 1e-14);
+        assert(std::abs(cg::fast::cos(x) - std::cos(x)) < 1e-14);
+    }
+    // outside the domains the libm answer comes back
+    std::vector<double> edge{-1.0, 0.0, 1e-320, INFINITY}, edge_out(4);
+    cg::fast::log(edge, edge_out);
+    assert(std::isnan(edge_out[0]) && edge_out[1] == -INFINITY && edge_out[2] == std::log(1e-320));
+    assert(cg::fast::exp(800.0) == INFINITY && cg::fast::pow(-2.0, 3.0) == -8.0);
+
+    // pass: every libm node swapped, same ids, results within the bound
+    cg::Graph<T> G;
+    auto x = cg::input(G, "x");
+    auto y = cg::input(G, "y");
+    auto f = cg::exp(cg::sin(x)) * cg::log(y) + cg::pow(y, cg::cos(x));
+    cg::Context<T> ctx{{"x", 1.3}, {"y", 4.2}};
+    cg::Evaluator<T, cg::eval::NaiveEvaluator> naive;
+    const T exact = naive.evaluate(G, f.root(), ctx);
+
+    cg::Evaluator<T, cg::eval::FastMathEvaluator> fast_policy({.absolute_tolerance = 1e-14});
+    assert(rel(fast_policy.evaluate(G, f.root(), ctx), exact) < 1e-7);
+
+    // a tight tolerance only lets exp and log through
+    cg::Graph<T> H;
+    auto hx = cg::input(H, "x");
+    cg::exp(cg::sin(hx)) + cg::log(hx);
+    assert(cg::opt::FastMath<T>(1e-10).run(H) == 2);
+
+    // near k pi the fast sin is only good in absolute terms, a relative tolerance alone never swaps it
+    cg::Graph<T> P;
+    auto near_pi = cg::sin(cg::input(P, "x"));
+    for (double dx : {0.0, 1e-12, -3e-9}) {
+        const double at = M_PI + dx;
+        assert(std::abs(cg::fast::sin(at) - std::sin(at)) < 1e-14);
+    }
+    assert(!cg::fast::within(cg::fast::Function::sin, 1e-3, 0.0));
+    assert(cg::opt::FastMath<T>(1e-3).run(P) == 0);
+    assert(naive.evaluate(P, near_pi.root(), {{"x", M_PI}}) == std::sin(M_PI));
+    assert(cg::opt::FastMath<T>(1e-3, 1e-14).run(P) == 1);
+
+    assert(cg::opt::FastMath<T>().run(G) == 3);
+    assert(cg::opt::FastMath<T>(1e-7, 1e-14).run(G) == 2);
+    assert(G.size() == 9);
+    const T approx_value = naive.evaluate(G, f.root(), ctx);
+    assert(approx_value != exact && rel(approx_value, exact) < 1e-7);
+
+    // batch kernels on the swapped graph
+    cg::FrozenGraph<T> frozen(std::move(G));
+    std::vector<T> col_x, col_y, bulk(1000);
+    for (int i = 0; i < 1000; ++i) {
+        col_x.push_back(-5.0 + 0.01 * i);
+        col_y.push_back(0.1 + 0.01 * i);
+    }
+    cg::eval::Columnar<T> table{{col_x, col_y}};
+    cg::eval::bulk_evaluate(frozen, f.root(), table, std::span<T>(bulk));
+    for (int i = 0; i < 1000; ++i) {
+        const T xi = col_x[i], yi = col_y[i];
+        assert(rel(bulk[i], std::exp(std::sin(xi)) * std::log(yi) + std::pow(yi, std::cos(xi))) < 1e-7);
+    }
+
+    // dual graphs keep the exact ops
+    cg::Graph<cg::Dual<T>> D;
+    cg::sin(cg::input(D, "x"));
+    assert(cg::opt::FastMath<cg::Dual<T>>().run(D) == 0);
+}
+
+TESTCASE(test_mixed_precision) {
+    using T = double;
+    using cg::eval::Precision;
+    cg::Graph<T> G;
+    auto x = cg::input(G, "x");
+    auto y = cg::input(G, "y");
+    auto shifted = x + 1e-4;
+    auto gap = shifted - x;             // cancels in float
+    auto f = gap * cg::exp(cg::sin(y));
+    cg::FrozenGraph<T> frozen(std::move(G));
+
+    std::vector<T> xs, ys;
+    for (int i = 0; i < 100; ++i) {
+        xs.push_back(1000.0 + i);
+        ys.push_back(0.01 * i);
+    }
+    cg::eval::Columnar<T> table{{xs, ys}};
+    auto exact = [&](int i) { return ((xs[i] + 1e-4) - xs[i]) * std::exp(std::sin(ys[i])); };
+
+    // all double is the plain evaluation, bit for bit
+    cg::eval::MixedPrecision wide(frozen, cg::eval::PrecisionPlan::uniform(Precision::f64));
+    const T at[] = {1003.0, 0.5};
+    assert(wide.evaluate(f.root(), at) == frozen.evaluate(f.root(), at));
+
+    // all float loses the gap
+    cg::eval::MixedPrecision narrow(frozen);
+    assert(narrow.precision(gap.root()) == Precision::f32 && narrow.promoted() == 3); // x, y and the constant
+    std::vector<T> out(xs.size());
+    narrow.evaluate(f.root(), table, std::span<T>(out));
+    assert(std::abs(out[50] - exact(50)) / exact(50) > 1e-3);
+
+    // the report points at the subtraction as the node that introduced the error
+    auto report = cg::eval::precision_report(narrow, table, 3);
+    assert(report.size() == 3);
+    auto worst_introduced = std::max_element(report.begin(), report.end(), [](const auto& a, const auto& b) {
+        return a.introduced < b.introduced;
+    });
+    assert(worst_introduced->id == gap.root() && worst_introduced->label == "-");
+
+    // promoting the sensitive ops plus the shift keeps the result within float rounding of the rest
+    auto plan = cg::eval::PrecisionPlan::sensitive().set(shifted.root(), Precision::f64);
+    cg::eval::MixedPrecision mixed(frozen, plan);
+    assert(mixed.precision(gap.root()) == Precision::f64 && mixed.precision(f.root()) == Precision::f32);
+    mixed.evaluate(f.root(), table, std::span<T>(out), {.chunk_rows = 16});
+    for (int i = 0; i < 100; ++i) assert(std::abs(out[i] - exact(i)) <= 1e-6 * std::abs(exact(i)) + 1e-9);
+}
+
+TESTCASE(test_tensor) {
+    using M = cg::Tensor<double>;
+    cg::Graph<M> G;
+    auto W = cg::input(G, "W");
+    auto x = cg::input(G, "x");
+    auto b = cg::constant(G, M::column({0.5, -0.5}));
+    auto h = cg::matmul(W, x) + b;           // 2x1
+    auto y = cg::sum(h * h) + cg::sin(h);    // 1x1 broadcast against 2x1
+    auto row = h * cg::constant(G, M(1, 3, {1.0, 2.0, 3.0})); // 2x1 by 1x3 -> 2x3
+
+    cg::FrozenGraph<M> frozen(std::move(G));
+    const M inputs[] = {M(2, 3, {1, 2, 3, 4, 5, 6}), M::column({1, 0, -1})};
+    // W x = [-2, -2], + b = [-1.5, -2.5], sum of squares 8.5
+    const M expected = M::column({8.5 + std::sin(-1.5), 8.5 + std::sin(-2.5)});
+    M out;
+    frozen.evaluate(y.root(), inputs, out);
+    assert(out.shape() == expected.shape());
+    for (std::size_t i = 0; i < 2; ++i) assert(approx(out[i], expected[i]));
+
+    const M outer = frozen.evaluate(row.root(), inputs);
+    assert(outer.rows() == 2 && outer.cols() == 3 && approx(outer(1, 2), -7.5));
+
+    // the second evaluation writes into the storage the first one left behind
+    const double* storage = out.data();
+    frozen.evaluate(y.root(), inputs, out);
+    assert(out.data() == storage);
+
+    // every evaluator agrees, shapes are checked
+    cg::Evaluator<M, cg::eval::NaiveEvaluator> naive;
+    cg::Evaluator<M, cg::eval::LazyEvaluator> lazy;
+    cg::Context<M> ctx{{"W", inputs[0]}, {"x", inputs[1]}};
+    assert(naive.evaluate(frozen.graph(), y.root(), ctx) == out);
+    assert(lazy.evaluate(frozen.graph(), y.root(), ctx) == out);
+    ctx["x"] = M::column({1, 2});
+    bool threw = false;
+    try { naive.evaluate(frozen.graph(), y.root(), ctx); } catch (const std::runtime_error&) { threw = true; }
+    assert(threw);
+    // the message shows both shapes as rows x cols, whichever axis disagrees
+    std::string message;
+    try { (void)(M(2, 3) + M(2, 4)); } catch (const std::runtime_error& e) { message = e.what(); }
+    assert(message == "cannot broadcast a 2x3 tensor against a 2x4 one");
+}
+
 int main() {
     test_arithmetic();
     test_cse();
+    test_graph_edits();
     test_ad();
+    test_analysis();
+    test_value_numbering();
+    test_frozen();
+    test_bulk();
+    test_streaming();
+    test_tiled();
+    test_service();
+    test_sparse_jacobian();
+    test_nested_dual();
+    test_taylor();
+    test_tensor();
+    test_memory();
+    test_function_call();
+    test_scan();
+    test_parser();
+    test_fast_math();
+    test_mixed_precision();
     std::cout << "all tests passed! <3" << std::endl;
     return 0;
 }
\ No newline at end of file